@@ -0,0 +1,117 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+//==============================================================================
+/**
+    The time accounting behind processBlock, with the clock, the detector and
+    the shared segment left to the caller, so a captured session can be
+    replayed through exactly this code under a virtual clock (see
+    tools/replay).
+
+    Active time is offered to the shared segment first. Whatever it cannot
+    take is accumulated for the current window in fractional milliseconds and
+    handed back, rounded, when the window closes, so the total doesn't depend
+    on the host's buffer size or sample rate.
+
+    The segment merges wall-clock ranges, so each block is laid end to end on
+    this instance's own timeline, starting no earlier than the wall clock.
+    Blocks delivered faster than real time would otherwise overlap themselves
+    and be counted once; instead the timeline runs ahead of the clock, and once
+    it is more than maxLeadMs ahead, or the host says it is rendering offline,
+    the time is accounted locally, at its sample duration.
+*/
+class ActivityAccountant
+{
+public:
+    struct Block
+    {
+        int64_t nowMs = 0;          // wall time at the start of the block
+        int64_t windowStart = 0;    // start of the window containing nowMs, in seconds
+        int numSamples = 0;
+        double sampleRate = 0.0;
+        bool active = false;        // detector verdict; false while bypassed
+        bool nonRealtime = false;   // AudioProcessor::isNonRealtime(), e.g. an offline bounce
+    };
+
+    struct Outcome
+    {
+        bool windowRolled = false;
+        int64_t closedWindow = 0;
+        int closedMilliseconds = 0; // local time of the closed window, 0 if the shared segment took it all
+    };
+
+    /** Starts accounting at windowStart without closing anything. */
+    void reset (int64_t windowStart)
+    {
+        currentWindow = windowStart;
+        localMilliseconds = 0.0;
+        windowMilliseconds = 0.0;
+    }
+
+    /** Accounts one block. markShared (fromMs, toMs) returns false if the shared
+        segment could not record the range; it is only called for active blocks.
+    */
+    template <typename MarkShared>
+    Outcome process (const Block& block, MarkShared&& markShared)
+    {
+        Outcome outcome;
+
+        if (block.windowStart != currentWindow) {
+            outcome.windowRolled = true;
+            outcome.closedWindow = currentWindow;
+            outcome.closedMilliseconds = static_cast<int> (std::lround (localMilliseconds));
+            reset (block.windowStart);
+        }
+
+        if (block.active && block.sampleRate > 0.0) {
+            auto chunkMilliseconds = block.numSamples / block.sampleRate * 1000.0;
+            windowMilliseconds += chunkMilliseconds;
+
+            const auto from = std::max (static_cast<double> (block.nowMs), timelineMs);
+            const auto shareable = !block.nonRealtime && from - static_cast<double> (block.nowMs) <= maxLeadMs;
+            if (shareable) {
+                timelineMs = from + chunkMilliseconds;
+            }
+            if (!shareable || !markShared (std::llround (from), std::llround (from + chunkMilliseconds))) {
+                localMilliseconds += chunkMilliseconds;
+            }
+        }
+
+        return outcome;
+    }
+
+    /** Closes the current window, e.g. at the end of a replay. */
+    Outcome flush()
+    {
+        Outcome outcome { true, currentWindow, static_cast<int> (std::lround (localMilliseconds)) };
+        localMilliseconds = 0.0;
+        windowMilliseconds = 0.0;
+        return outcome;
+    }
+
+    int64_t getCurrentWindow() const noexcept { return currentWindow; }
+
+    /** Active time in the current window so far, wherever it was accounted. */
+    double getWindowMilliseconds() const noexcept { return windowMilliseconds; }
+
+    /** Same window math as ClockService::getWindowStart(), for a given time. */
+    static int64_t windowStartFor (int64_t nowMs, int durationSeconds)
+    {
+        auto nowSeconds = nowMs / 1000;
+        return nowSeconds - nowSeconds % durationSeconds;
+    }
+
+    /** How far the timeline may run ahead of the wall clock, e.g. through a
+        host's jittery or bursty block delivery, before blocks count locally.
+    */
+    static constexpr double maxLeadMs = 2000.0;
+
+private:
+    int64_t currentWindow = 0;
+    double timelineMs = 0.0;    // end of the last range offered to the shared segment
+    double localMilliseconds = 0.0;
+    double windowMilliseconds = 0.0;
+};
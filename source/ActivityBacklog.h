@@ -0,0 +1,224 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+
+//==============================================================================
+/**
+    The activity an instance has recorded but not yet had acknowledged, keyed by
+    the start of each span in seconds.
+
+    Recent windows stay at full resolution. Once the backlog grows past its
+    budget (a number of entries, or the request size they would produce),
+    compact() merges the oldest windows into per-minute buckets, then per-hour
+    and per-day ones, each holding the sum of what it replaced. The total is
+    unchanged, so however long the machine is offline, memory, the copy taken
+    for each submission and the request body stay bounded.
+
+    Not thread safe; the processor guards it with its lock.
+*/
+class ActivityBacklog
+{
+public:
+    struct Span
+    {
+        int milliseconds = 0;
+        int seconds = 0;            // length of the span; the window length until merged
+        int part = 0;               // parts of the span already acknowledged, see acknowledge()
+    };
+
+    struct Budget
+    {
+        int maxEntries = 1024;
+        int maxPayloadBytes = 64 * 1024;
+
+        /** About what one entry adds to a request: its activity value plus its idempotency key. */
+        static constexpr int bytesPerEntry = 72;
+        static constexpr int minEntries = 64;
+
+        size_t getEntryLimit() const noexcept
+        {
+            return static_cast<size_t> (std::max (minEntries, std::min (maxEntries, maxPayloadBytes / bytesPerEntry)));
+        }
+    };
+
+    using Spans = std::map<int, Span>;
+
+    explicit ActivityBacklog (int windowSecondsToUse) : windowSeconds (windowSecondsToUse) {}
+
+    void setBudget (const Budget& newBudget) noexcept { budget = newBudget; }
+    const Budget& getBudget() const noexcept { return budget; }
+
+    /** Records a closed window. Does nothing if the window is already recorded. */
+    void add (int window, int milliseconds)
+    {
+        spans.emplace (window, Span { milliseconds, windowSeconds, 0 });
+    }
+
+    /** Merges a window from another source. The same window keeps the larger of
+        the two values; a window that has already been merged into a bucket
+        (e.g. one handed back by an instance that closed) is added to it.
+    */
+    void merge (int window, int milliseconds)
+    {
+        if (auto* bucket = findBucketContaining (window)) {
+            bucket->milliseconds = std::min (bucket->milliseconds + milliseconds, bucket->seconds * 1000);
+            return;
+        }
+
+        auto& recorded = spans.try_emplace (window, Span { 0, windowSeconds, 0 }).first->second;
+        recorded.milliseconds = std::max (recorded.milliseconds, milliseconds);
+    }
+
+    /** Takes an acknowledged submission off the backlog: each span it carried
+        loses exactly the milliseconds that were sent. Time that reached a span
+        after the snapshot was taken (a later harvest, a window handed back)
+        stays pending as the span's next part, which is submitted under a key
+        of its own so the server doesn't drop it as a retry.
+    */
+    void acknowledge (const Spans& submitted)
+    {
+        for (const auto& [start, sent] : submitted) {
+            auto it = spans.find (start);
+            if (it == spans.end() || it->second.seconds != sent.seconds || it->second.part != sent.part) {
+                continue;
+            }
+
+            it->second.milliseconds -= sent.milliseconds;
+            if (it->second.milliseconds <= 0) {
+                spans.erase (it);
+            } else {
+                ++it->second.part;
+            }
+        }
+    }
+
+    /** Merges the oldest windows into coarser buckets until the backlog fits its
+        budget. Everything newer than minFullResolutionSeconds is left alone, so
+        windows still being harvested or closed never land in a bucket.
+        Returns the number of entries removed.
+    */
+    size_t compact (int64_t nowSeconds)
+    {
+        const auto limit = budget.getEntryLimit();
+        const auto before = spans.size();
+
+        // each tier's horizon is a multiple of the previous one; they shrink together until the backlog fits
+        for (auto horizon = fullResolutionSeconds; spans.size() > limit; horizon /= 2) {
+            horizon = std::max (horizon, minFullResolutionSeconds);
+
+            auto age = horizon;
+            for (const auto& tier : tiers) {
+                mergeOlderThan (nowSeconds - age, tier.seconds);
+                age *= tier.horizonFactor;
+                if (spans.size() <= limit) {
+                    break;
+                }
+            }
+
+            if (horizon == minFullResolutionSeconds) {
+                break;
+            }
+        }
+
+        // a budget that tight gets whole tiers of everything but the newest windows
+        for (const auto& tier : tiers) {
+            if (spans.size() <= limit) {
+                break;
+            }
+            mergeOlderThan (nowSeconds - minFullResolutionSeconds, tier.seconds);
+        }
+
+        return before - spans.size();
+    }
+
+    /** Calls fn (window, milliseconds) for a span split back into windows, filling
+        each from the start of the span, e.g. to hand it to a segment that only
+        holds windows.
+    */
+    template <typename Fn>
+    void forEachWindow (int start, const Span& span, Fn&& fn) const
+    {
+        auto remaining = span.milliseconds;
+        for (auto window = start; window < start + span.seconds && remaining > 0; window += windowSeconds) {
+            auto milliseconds = std::min (remaining, windowSeconds * 1000);
+            fn (window, milliseconds);
+            remaining -= milliseconds;
+        }
+    }
+
+    bool isWindow (const Span& span) const noexcept { return span.seconds <= windowSeconds; }
+
+    bool empty() const noexcept { return spans.empty(); }
+    size_t size() const noexcept { return spans.size(); }
+
+    const Spans& getSpans() const noexcept { return spans; }
+    Spans::const_iterator begin() const noexcept { return spans.begin(); }
+    Spans::const_iterator end() const noexcept { return spans.end(); }
+
+    static constexpr int64_t fullResolutionSeconds = 60 * 60;
+    static constexpr int64_t minFullResolutionSeconds = 10 * 60;
+
+private:
+    struct Tier
+    {
+        int seconds;
+        int64_t horizonFactor;      // the next tier starts this many times further back
+    };
+
+    // minutes after an hour, hours after a day, days after a week (at the full horizon)
+    static constexpr std::array<Tier, 3> tiers { { { 60, 24 }, { 60 * 60, 7 }, { 24 * 60 * 60, 1 } } };
+
+    const int windowSeconds;
+    Budget budget;
+    Spans spans;
+
+    static int64_t floorTo (int64_t value, int64_t step)
+    {
+        auto remainder = value % step;
+        return remainder < 0 ? value - remainder - step : value - remainder;
+    }
+
+    /** Folds every span finer than bucketSeconds that lies wholly before cutoff into its bucket. */
+    void mergeOlderThan (int64_t cutoff, int bucketSeconds)
+    {
+        // aligned, so a bucket is only ever created complete
+        cutoff = floorTo (cutoff, bucketSeconds);
+
+        Spans merged;
+        auto it = spans.begin();
+        while (it != spans.end() && it->first < cutoff) {
+            auto& bucket = merged[static_cast<int> (floorTo (it->first, bucketSeconds))];
+            bucket.milliseconds += it->second.milliseconds;
+            bucket.seconds = std::max (bucketSeconds, it->second.seconds);
+            if (it->second.seconds >= bucketSeconds) {
+                bucket.part = std::max (bucket.part, it->second.part);   // a bucket folded into itself keeps its key
+            }
+            ++it;
+        }
+
+        if (merged.size() >= static_cast<size_t> (std::distance (spans.begin(), it))) {
+            return;
+        }
+
+        spans.erase (spans.begin(), it);
+        spans.merge (merged);
+    }
+
+    Span* findBucketContaining (int window)
+    {
+        auto it = spans.upper_bound (window);
+        if (it == spans.begin()) {
+            return nullptr;
+        }
+
+        --it;
+        if (isWindow (it->second) || window >= it->first + it->second.seconds) {
+            return nullptr;
+        }
+        return &it->second;
+    }
+};
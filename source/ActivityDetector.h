@@ -0,0 +1,188 @@
+#pragma once
+
+#include <cmath>
+#include <JuceHeader.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+ #include <emmintrin.h>
+ #define SIGNALBASH_DETECTOR_SSE2 1
+#elif defined(__ARM_NEON) && (defined(__aarch64__) || defined(_M_ARM64))
+ #include <arm_neon.h>
+ #define SIGNALBASH_DETECTOR_NEON 1
+#endif
+
+//==============================================================================
+/**
+    Signal detector shared by the float and double processing paths.
+
+    A channel counts as active when its RMS level over the block reaches the
+    threshold. The comparison is done on the sum of squares against a
+    precomputed power, so there is no sqrt or log10 per block, and the sum of
+    squares has a SIMD kernel per sample type (SSE2 on x86-64, NEON on arm64).
+*/
+class ActivityDetector
+{
+public:
+    explicit ActivityDetector (double thresholdDb)
+        : thresholdPower (std::pow (10.0, thresholdDb / 10.0))
+    {
+    }
+
+    /** True if any of the first numChannels channels is at or above the threshold. */
+    template <typename FloatType>
+    bool isActive (const juce::AudioBuffer<FloatType>& buffer, int numChannels) const
+    {
+        const auto numSamples = buffer.getNumSamples();
+        if (numSamples <= 0) {
+            return false;
+        }
+
+        for (int channel = 0; channel < numChannels; ++channel) {
+            if (isChannelActive (sumOfSquares (buffer.getReadPointer (channel), numSamples), numSamples)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /** The per-channel verdict from a precomputed sum of squares, e.g. from a captured envelope. */
+    bool isChannelActive (double channelSumOfSquares, int numSamples) const noexcept
+    {
+        return numSamples > 0 && channelSumOfSquares >= thresholdPower * numSamples;
+    }
+
+    static double sumOfSquares (const float* data, int numSamples)   { return floatKernel<false> (data, numSamples, nullptr); }
+    static double sumOfSquares (const double* data, int numSamples)  { return doubleKernel<false> (data, numSamples, nullptr); }
+
+    /** Same pass, also tracking the largest squared sample (for a peak meter). */
+    static double sumOfSquares (const float* data, int numSamples, double& peakSquared)   { return floatKernel<true> (data, numSamples, &peakSquared); }
+    static double sumOfSquares (const double* data, int numSamples, double& peakSquared)  { return doubleKernel<true> (data, numSamples, &peakSquared); }
+
+private:
+    template <bool trackPeak>
+    static double floatKernel (const float* data, int numSamples, [[maybe_unused]] double* peakSquared)
+    {
+        int i = 0;
+        double sum = 0.0;
+        [[maybe_unused]] double peak = 0.0;
+
+       #if SIGNALBASH_DETECTOR_SSE2
+        __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+        [[maybe_unused]] __m128 max0 = _mm_setzero_ps(), max1 = _mm_setzero_ps();
+        for (; i + 8 <= numSamples; i += 8) {
+            auto a = _mm_loadu_ps (data + i);
+            auto b = _mm_loadu_ps (data + i + 4);
+            auto aa = _mm_mul_ps (a, a);
+            auto bb = _mm_mul_ps (b, b);
+            acc0 = _mm_add_ps (acc0, aa);
+            acc1 = _mm_add_ps (acc1, bb);
+            if constexpr (trackPeak) {
+                max0 = _mm_max_ps (max0, aa);
+                max1 = _mm_max_ps (max1, bb);
+            }
+        }
+        alignas (16) float lanes[4];
+        _mm_store_ps (lanes, _mm_add_ps (acc0, acc1));
+        sum = static_cast<double> (lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+        if constexpr (trackPeak) {
+            _mm_store_ps (lanes, _mm_max_ps (max0, max1));
+            peak = juce::jmax (lanes[0], lanes[1], lanes[2], lanes[3]);
+        }
+       #elif SIGNALBASH_DETECTOR_NEON
+        float32x4_t acc0 = vdupq_n_f32 (0.0f), acc1 = vdupq_n_f32 (0.0f);
+        [[maybe_unused]] float32x4_t max0 = vdupq_n_f32 (0.0f), max1 = vdupq_n_f32 (0.0f);
+        for (; i + 8 <= numSamples; i += 8) {
+            auto a = vld1q_f32 (data + i);
+            auto b = vld1q_f32 (data + i + 4);
+            acc0 = vmlaq_f32 (acc0, a, a);
+            acc1 = vmlaq_f32 (acc1, b, b);
+            if constexpr (trackPeak) {
+                max0 = vmaxq_f32 (max0, vabsq_f32 (a));
+                max1 = vmaxq_f32 (max1, vabsq_f32 (b));
+            }
+        }
+        sum = static_cast<double> (vaddvq_f32 (vaddq_f32 (acc0, acc1)));
+        if constexpr (trackPeak) {
+            auto largest = static_cast<double> (vmaxvq_f32 (vmaxq_f32 (max0, max1)));
+            peak = largest * largest;
+        }
+       #endif
+
+        for (; i < numSamples; ++i) {
+            auto square = static_cast<double> (data[i]) * data[i];
+            sum += square;
+            if constexpr (trackPeak) {
+                peak = juce::jmax (peak, square);
+            }
+        }
+
+        if constexpr (trackPeak) {
+            *peakSquared = peak;
+        }
+        return sum;
+    }
+
+    template <bool trackPeak>
+    static double doubleKernel (const double* data, int numSamples, [[maybe_unused]] double* peakSquared)
+    {
+        int i = 0;
+        double sum = 0.0;
+        [[maybe_unused]] double peak = 0.0;
+
+       #if SIGNALBASH_DETECTOR_SSE2
+        __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+        [[maybe_unused]] __m128d max0 = _mm_setzero_pd(), max1 = _mm_setzero_pd();
+        for (; i + 4 <= numSamples; i += 4) {
+            auto a = _mm_loadu_pd (data + i);
+            auto b = _mm_loadu_pd (data + i + 2);
+            auto aa = _mm_mul_pd (a, a);
+            auto bb = _mm_mul_pd (b, b);
+            acc0 = _mm_add_pd (acc0, aa);
+            acc1 = _mm_add_pd (acc1, bb);
+            if constexpr (trackPeak) {
+                max0 = _mm_max_pd (max0, aa);
+                max1 = _mm_max_pd (max1, bb);
+            }
+        }
+        alignas (16) double lanes[2];
+        _mm_store_pd (lanes, _mm_add_pd (acc0, acc1));
+        sum = lanes[0] + lanes[1];
+        if constexpr (trackPeak) {
+            _mm_store_pd (lanes, _mm_max_pd (max0, max1));
+            peak = juce::jmax (lanes[0], lanes[1]);
+        }
+       #elif SIGNALBASH_DETECTOR_NEON
+        float64x2_t acc0 = vdupq_n_f64 (0.0), acc1 = vdupq_n_f64 (0.0);
+        [[maybe_unused]] float64x2_t max0 = vdupq_n_f64 (0.0), max1 = vdupq_n_f64 (0.0);
+        for (; i + 4 <= numSamples; i += 4) {
+            auto a = vld1q_f64 (data + i);
+            auto b = vld1q_f64 (data + i + 2);
+            acc0 = vfmaq_f64 (acc0, a, a);
+            acc1 = vfmaq_f64 (acc1, b, b);
+            if constexpr (trackPeak) {
+                max0 = vmaxq_f64 (max0, vmulq_f64 (a, a));
+                max1 = vmaxq_f64 (max1, vmulq_f64 (b, b));
+            }
+        }
+        sum = vaddvq_f64 (vaddq_f64 (acc0, acc1));
+        if constexpr (trackPeak) {
+            peak = vmaxvq_f64 (vmaxq_f64 (max0, max1));
+        }
+       #endif
+
+        for (; i < numSamples; ++i) {
+            auto square = data[i] * data[i];
+            sum += square;
+            if constexpr (trackPeak) {
+                peak = juce::jmax (peak, square);
+            }
+        }
+
+        if constexpr (trackPeak) {
+            *peakSquared = peak;
+        }
+        return sum;
+    }
+
+    double thresholdPower;
+};
@@ -0,0 +1,361 @@
+#include <cstring>
+#include <limits>
+
+#include "ActivityHistoryStore.h"
+
+namespace
+{
+    constexpr char historyMagic[4] = { 'S', 'B', 'A', 'H' };
+
+    struct ScopedProcessLock
+    {
+        ScopedProcessLock (juce::InterProcessLock& l, int timeoutMs) : lock (l), locked (l.enter (timeoutMs)) {}
+        ~ScopedProcessLock() { if (locked) lock.exit(); }
+
+        juce::InterProcessLock& lock;
+        const bool locked;
+    };
+
+    size_t fileSizeFor (uint32_t capacity)
+    {
+        return 64 + static_cast<size_t>(capacity) * (sizeof (int64_t) + sizeof (int32_t) + 2 * sizeof (uint32_t));
+    }
+}
+
+//==============================================================================
+ActivityHistoryStore::ActivityHistoryStore()
+    : ActivityHistoryStore (getDefaultFile(), defaultCapacity)
+{
+}
+
+ActivityHistoryStore::ActivityHistoryStore (const juce::File& fileToUse, uint32_t capacityToUse)
+    : file (fileToUse), capacity (capacityToUse)
+{
+    ScopedProcessLock guard (processLock, 2000);
+    if (!guard.locked) {
+        DBG("Activity history: could not lock " << file.getFullPathName());
+        return;
+    }
+
+    open();
+    if (isOpen()) {
+        rebuildAggregates();
+    }
+}
+
+ActivityHistoryStore::~ActivityHistoryStore() = default;
+
+juce::File ActivityHistoryStore::getDefaultFile()
+{
+    return juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory)
+        .getChildFile ("Signalbash")
+        .getChildFile ("activity_history.bin");
+}
+
+uint32_t ActivityHistoryStore::hashOf (const juce::String& text)
+{
+    uint32_t h = 2166136261u;
+    for (auto* p = text.toRawUTF8(); *p != 0; ++p) {
+        h ^= static_cast<unsigned char>(*p);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+//==============================================================================
+void ActivityHistoryStore::open()
+{
+    const auto expectedSize = fileSizeFor (capacity);
+
+    auto isUsable = [this, expectedSize]
+    {
+        if (!file.existsAsFile() || static_cast<size_t>(file.getSize()) != expectedSize) {
+            return false;
+        }
+
+        Header existing;
+        juce::FileInputStream in (file);
+        return in.openedOk()
+            && in.read (&existing, sizeof (existing)) == static_cast<int>(sizeof (existing))
+            && std::memcmp (existing.magic, historyMagic, sizeof (historyMagic)) == 0
+            && existing.version == currentVersion
+            && existing.capacity == capacity
+            && existing.count.load() <= capacity;
+    };
+
+    if (!isUsable()) {
+        file.getParentDirectory().createDirectory();
+
+        juce::MemoryBlock initial (expectedSize, true);
+        Header fresh {};
+        std::memcpy (fresh.magic, historyMagic, sizeof (historyMagic));
+        fresh.version = currentVersion;
+        fresh.capacity = capacity;
+        initial.copyFrom (&fresh, 0, sizeof (fresh));
+
+        if (!file.replaceWithData (initial.getData(), initial.getSize())) {
+            DBG("Activity history: could not create " << file.getFullPathName());
+            return;
+        }
+    }
+
+    mappedFile = std::make_unique<juce::MemoryMappedFile> (file, juce::MemoryMappedFile::readWrite);
+    if (mappedFile->getData() == nullptr || mappedFile->getSize() != expectedSize) {
+        DBG("Activity history: could not map " << file.getFullPathName());
+        mappedFile.reset();
+    }
+}
+
+ActivityHistoryStore::Header* ActivityHistoryStore::header() const
+{
+    return static_cast<Header*>(mappedFile->getData());
+}
+
+int64_t* ActivityHistoryStore::timestamps() const
+{
+    return reinterpret_cast<int64_t*>(static_cast<char*>(mappedFile->getData()) + sizeof (Header));
+}
+
+int32_t* ActivityHistoryStore::milliseconds() const
+{
+    return reinterpret_cast<int32_t*>(timestamps() + capacity);
+}
+
+uint32_t* ActivityHistoryStore::hosts() const
+{
+    return reinterpret_cast<uint32_t*>(milliseconds() + capacity);
+}
+
+uint32_t* ActivityHistoryStore::instances() const
+{
+    return hosts() + capacity;
+}
+
+ActivityHistoryStore::Record ActivityHistoryStore::readRecord (uint32_t index) const
+{
+    return { timestamps()[index], milliseconds()[index], hosts()[index], instances()[index] };
+}
+
+void ActivityHistoryStore::writeRecord (uint32_t index, const Record& record)
+{
+    timestamps()[index] = record.timestamp;
+    milliseconds()[index] = record.milliseconds;
+    hosts()[index] = record.host;
+    instances()[index] = record.instance;
+}
+
+//==============================================================================
+void ActivityHistoryStore::append (const std::vector<Record>& records)
+{
+    const juce::ScopedLock sl (lock);
+    if (!isOpen() || records.empty()) {
+        return;
+    }
+
+    ScopedProcessLock guard (processLock, 2000);
+    if (!guard.locked) {
+        DBG("Activity history: lock timed out, dropping " << (int) records.size() << " windows");
+        return;
+    }
+
+    catchUpLocked();
+
+    std::vector<Record> fresh;
+    fresh.reserve (records.size());
+    for (const auto& record : records) {
+        auto last = lastTimestampByInstance.find (record.instance);
+        if (last == lastTimestampByInstance.end() || record.timestamp > last->second) {
+            fresh.push_back (record);
+        }
+    }
+
+    if (fresh.size() > capacity / 2) {
+        fresh.erase (fresh.begin(), fresh.end() - static_cast<std::ptrdiff_t>(capacity / 2));
+    }
+
+    auto* h = header();
+    if (h->count.load (std::memory_order_relaxed) + fresh.size() > capacity) {
+        compactLocked (fresh.size());
+    }
+
+    auto count = h->count.load (std::memory_order_relaxed);
+    for (const auto& record : fresh) {
+        writeRecord (count, record);
+        accumulate (record);
+        ++count;
+    }
+
+    // after the rows, so a peek that sees the new count finds them written
+    h->count.store (count, std::memory_order_release);
+    seenCount = count;
+}
+
+void ActivityHistoryStore::refresh()
+{
+    const juce::ScopedTryLock stl (lock);
+    if (!stl.isLocked() || !isOpen()) {
+        return;
+    }
+
+    // peek without the process lock: the header fields are atomics, and a writer
+    // caught mid-update only delays the catch-up, which runs under the lock, to the next call
+    auto* h = header();
+    if (h->count.load (std::memory_order_acquire) == seenCount
+        && h->generation.load (std::memory_order_acquire) == seenGeneration) {
+        return;
+    }
+
+    ScopedProcessLock guard (processLock, 0);
+    if (guard.locked) {
+        catchUpLocked();
+    }
+}
+
+void ActivityHistoryStore::catchUpLocked()
+{
+    auto* h = header();
+    const auto count = h->count.load (std::memory_order_acquire);
+
+    if (h->generation.load (std::memory_order_acquire) != seenGeneration || count < seenCount) {
+        rebuildAggregates();
+        return;
+    }
+
+    for (auto i = seenCount; i < count; ++i) {
+        accumulate (readRecord (i));
+    }
+    seenCount = count;
+}
+
+void ActivityHistoryStore::compactLocked (size_t spaceNeeded)
+{
+    auto* h = header();
+    const auto now = juce::Time::currentTimeMillis() / 1000;
+    const auto hourlyCutoff = now - 24 * 60 * 60;
+    const auto retentionCutoff = now - static_cast<int64_t>(retentionDays) * 24 * 60 * 60;
+
+    std::map<std::pair<int64_t, uint32_t>, int64_t> hourly;
+    std::vector<Record> recent;
+
+    const auto count = h->count.load (std::memory_order_relaxed);
+    for (uint32_t i = 0; i < count; ++i) {
+        auto record = readRecord (i);
+        if (record.timestamp < retentionCutoff) {
+            continue;
+        }
+        if (record.timestamp < hourlyCutoff) {
+            hourly[{ record.timestamp - record.timestamp % 3600, record.host }] += record.milliseconds;
+        } else {
+            recent.push_back (record);
+        }
+    }
+
+    std::vector<Record> compacted;
+    compacted.reserve (hourly.size() + recent.size());
+    for (const auto& [key, ms] : hourly) {
+        compacted.push_back ({ key.first, static_cast<int32_t>(juce::jmin<int64_t>(ms, std::numeric_limits<int32_t>::max())), key.second, 0 });
+    }
+    compacted.insert (compacted.end(), recent.begin(), recent.end());
+
+    // still crowded: keep the newest half so the next compaction is far away
+    if (compacted.size() + spaceNeeded > (size_t) capacity * 3 / 4 && compacted.size() > capacity / 2) {
+        compacted.erase (compacted.begin(), compacted.end() - static_cast<std::ptrdiff_t>(capacity / 2));
+    }
+
+    for (uint32_t i = 0; i < compacted.size(); ++i) {
+        writeRecord (i, compacted[i]);
+    }
+
+    DBG("Activity history compacted: " << (int) count << " -> " << (int) compacted.size() << " rows");
+
+    h->count.store (static_cast<uint32_t>(compacted.size()), std::memory_order_release);
+    h->generation.fetch_add (1, std::memory_order_release);
+    rebuildAggregates();
+}
+
+//==============================================================================
+void ActivityHistoryStore::rebuildAggregates()
+{
+    for (auto& bucket : days)  { bucket.key.store (-1); bucket.milliseconds.store (0); }
+    for (auto& bucket : hours) { bucket.key.store (-1); bucket.milliseconds.store (0); }
+    lastTimestampByInstance.clear();
+
+    auto* h = header();
+    const auto count = h->count.load (std::memory_order_acquire);
+    for (uint32_t i = 0; i < count; ++i) {
+        accumulate (readRecord (i));
+    }
+
+    seenCount = count;
+    seenGeneration = h->generation.load (std::memory_order_acquire);
+}
+
+void ActivityHistoryStore::accumulate (const Record& record)
+{
+    auto add = [&record] (Bucket& bucket, int64_t key)
+    {
+        auto current = bucket.key.load();
+        if (key < current) {
+            return; // older than the ring covers
+        }
+        if (key > current) {
+            bucket.milliseconds.store (0);
+            bucket.key.store (key);
+        }
+        bucket.milliseconds.fetch_add (record.milliseconds);
+    };
+
+    auto day = localDayOf (record.timestamp);
+    add (days[static_cast<size_t>(day % numDays)], day);
+
+    auto hour = localHourOf (record.timestamp);
+    add (hours[static_cast<size_t>(hour % numHours)], hour);
+
+    if (record.instance != 0) {
+        auto& last = lastTimestampByInstance[record.instance];
+        last = juce::jmax (last, record.timestamp);
+    }
+}
+
+//==============================================================================
+int64_t ActivityHistoryStore::localDayOf (int64_t timestamp)
+{
+    auto offset = juce::Time (timestamp * 1000).getUTCOffsetSeconds();
+    return (timestamp + offset) / (24 * 60 * 60);
+}
+
+int64_t ActivityHistoryStore::localHourOf (int64_t timestamp)
+{
+    auto offset = juce::Time (timestamp * 1000).getUTCOffsetSeconds();
+    return (timestamp + offset) / (60 * 60);
+}
+
+int64_t ActivityHistoryStore::bucketValue (const Bucket& bucket, int64_t key)
+{
+    return bucket.key.load() == key ? bucket.milliseconds.load() : 0;
+}
+
+int64_t ActivityHistoryStore::getTodayMilliseconds() const
+{
+    auto today = localDayOf (juce::Time::currentTimeMillis() / 1000);
+    return bucketValue (days[static_cast<size_t>(today % numDays)], today);
+}
+
+int64_t ActivityHistoryStore::getThisWeekMilliseconds() const
+{
+    auto today = localDayOf (juce::Time::currentTimeMillis() / 1000);
+    auto weekStart = today - (today + 3) % 7; // weeks start on Monday; day 0 was a Thursday
+
+    int64_t total = 0;
+    for (auto day = weekStart; day <= today; ++day) {
+        total += bucketValue (days[static_cast<size_t>(day % numDays)], day);
+    }
+    return total;
+}
+
+int64_t ActivityHistoryStore::getHourMilliseconds (int hoursAgo) const
+{
+    jassert (hoursAgo >= 0 && hoursAgo < numHours);
+    auto hour = localHourOf (juce::Time::currentTimeMillis() / 1000) - hoursAgo;
+    return bucketValue (hours[static_cast<size_t>(hour % numHours)], hour);
+}
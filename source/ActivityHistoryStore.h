@@ -0,0 +1,120 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Local, append-only record of acknowledged activity windows, shared by all
+    instances in the process (hold it through a juce::SharedResourcePointer)
+    and, via the file, by every process of the same user.
+
+    Records are stored column-wise in a fixed-size memory-mapped file, so the
+    on-disk footprint never exceeds `capacity` records. When the file fills up,
+    windows older than a day are merged into hourly rows and the oldest rows are
+    dropped. Per-hour and per-day totals are kept incrementally as records
+    arrive, so "today" and "this week" are constant-time reads.
+*/
+class ActivityHistoryStore
+{
+public:
+    struct Record
+    {
+        int64_t timestamp;      // window start, seconds since epoch
+        int32_t milliseconds;
+        uint32_t host;          // hashOf (host name)
+        uint32_t instance;      // hashOf (deduplication ID), 0 for compacted rows
+    };
+
+    ActivityHistoryStore();
+    ActivityHistoryStore (const juce::File& file, uint32_t capacity);
+    ~ActivityHistoryStore();
+
+    /** Appends acknowledged windows. Windows an instance has already recorded
+        (e.g. re-sent in a later batch) are skipped.
+    */
+    void append (const std::vector<Record>& records);
+
+    /** Picks up records appended by other processes since the last call. Cheap
+        when nothing changed; never blocks waiting for another writer.
+    */
+    void refresh();
+
+    int64_t getTodayMilliseconds() const;
+    int64_t getThisWeekMilliseconds() const;
+
+    /** Total for the local hour `hoursAgo` hours before the current one (0 to 47). */
+    int64_t getHourMilliseconds (int hoursAgo) const;
+
+    bool isOpen() const { return mappedFile != nullptr && mappedFile->getData() != nullptr; }
+
+    static uint32_t hashOf (const juce::String& text);
+    static juce::File getDefaultFile();
+
+    static constexpr uint32_t defaultCapacity = 64 * 1024;
+    static constexpr int retentionDays = 365;
+
+private:
+    // count and generation are written under the process lock but peeked at
+    // without it by refresh(), from any process, so they are atomics in the mapping
+    struct Header
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t capacity;
+        std::atomic<uint32_t> count;
+        std::atomic<uint64_t> generation;
+        uint8_t reserved[40];
+    };
+    static_assert (sizeof (Header) == 64, "Header must stay 64 bytes");
+    static_assert (std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free,
+                   "the history header needs lock-free atomics to be shared between processes");
+
+    static constexpr uint32_t currentVersion = 1;
+    static constexpr int numDays = 8;
+    static constexpr int numHours = 48;
+
+    struct Bucket
+    {
+        std::atomic<int64_t> key { -1 };
+        std::atomic<int64_t> milliseconds { 0 };
+    };
+
+    juce::File file;
+    uint32_t capacity;
+    std::unique_ptr<juce::MemoryMappedFile> mappedFile;
+    juce::InterProcessLock processLock { "SignalbashActivityHistory" };
+    juce::CriticalSection lock;
+
+    uint32_t seenCount = 0;
+    uint64_t seenGeneration = 0;
+    std::map<uint32_t, int64_t> lastTimestampByInstance;
+
+    std::array<Bucket, numDays> days;
+    std::array<Bucket, numHours> hours;
+
+    void open();
+    Header* header() const;
+    int64_t* timestamps() const;
+    int32_t* milliseconds() const;
+    uint32_t* hosts() const;
+    uint32_t* instances() const;
+    Record readRecord (uint32_t index) const;
+    void writeRecord (uint32_t index, const Record& record);
+
+    void rebuildAggregates();
+    void accumulate (const Record& record);
+    void catchUpLocked();
+    void compactLocked (size_t spaceNeeded);
+
+    static int64_t localDayOf (int64_t timestamp);
+    static int64_t localHourOf (int64_t timestamp);
+    static int64_t bucketValue (const Bucket& bucket, int64_t key);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ActivityHistoryStore)
+};
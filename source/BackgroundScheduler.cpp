@@ -0,0 +1,142 @@
+#include "BackgroundScheduler.h"
+#include "Tracer.h"
+
+class BackgroundScheduler::Job : public juce::ThreadPoolJob
+{
+public:
+    Job (const void* ownerToUse, const char* traceNameToUse, std::function<void()> taskToRun)
+        : ThreadPoolJob ("BackgroundJob"), owner (ownerToUse), traceName (traceNameToUse), task (std::move (taskToRun))
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        SIGNALBASH_TRACE_SCOPE ("job", traceName);
+        task();
+        return jobHasFinished;
+    }
+
+    const void* const owner;
+
+private:
+    const char* traceName;
+    std::function<void()> task;
+};
+
+//==============================================================================
+BackgroundScheduler::BackgroundScheduler() = default;
+
+BackgroundScheduler::~BackgroundScheduler()
+{
+    stopTimer();
+
+    std::shared_ptr<juce::ThreadPool> released;
+    {
+        const juce::ScopedLock sl (lock);
+        released = std::move (pool);
+    }
+
+    if (released != nullptr)
+        released->removeAllJobs (true, 5000);
+}
+
+std::shared_ptr<juce::ThreadPool> BackgroundScheduler::getPool (bool createIfNeeded)
+{
+    const juce::ScopedLock sl (lock);
+
+    if (pool == nullptr && createIfNeeded) {
+        pool = std::make_shared<juce::ThreadPool> (juce::ThreadPoolOptions{}
+                                                       .withThreadName ("Signalbash Worker")
+                                                       .withNumberOfThreads (numThreads)
+                                                       .withThreadPriority (juce::Thread::Priority::background));
+        startTimer (idleCheckIntervalMs);
+    }
+
+    if (createIfNeeded)
+        lastSubmissionMs = juce::Time::getMillisecondCounter();
+
+    return pool;
+}
+
+void BackgroundScheduler::submit (const void* owner, const char* traceName, std::function<void()> task)
+{
+    getPool (true)->addJob (new Job (owner, traceName, std::move (task)), true);
+}
+
+bool BackgroundScheduler::cancelJobs (const void* owner, int timeoutMs)
+{
+    struct OwnerSelector : public juce::ThreadPool::JobSelector
+    {
+        explicit OwnerSelector (const void* o) : owner (o) {}
+
+        bool isJobSuitable (juce::ThreadPoolJob* job) override
+        {
+            auto* scheduled = dynamic_cast<Job*> (job);
+            return scheduled != nullptr && scheduled->owner == owner;
+        }
+
+        const void* owner;
+    };
+
+    // no lock while waiting: the owner's running jobs may still submit follow-ups
+    auto current = getPool (false);
+    if (current == nullptr) {
+        return true;
+    }
+
+    OwnerSelector selector (owner);
+    return current->removeAllJobs (true, timeoutMs, &selector);
+}
+
+bool BackgroundScheduler::isRunning() const
+{
+    const juce::ScopedLock sl (lock);
+    return pool != nullptr;
+}
+
+void BackgroundScheduler::timerCallback()
+{
+    std::shared_ptr<juce::ThreadPool> released;
+    {
+        const juce::ScopedLock sl (lock);
+        if (pool == nullptr) {
+            stopTimer();
+            return;
+        }
+
+        // idle pool threads still poll for work, so drop them once nothing has been queued for a while
+        if (pool->getNumJobs() == 0 && juce::Time::getMillisecondCounter() - lastSubmissionMs >= (juce::uint32) releaseAfterIdleMs) {
+            released = std::move (pool);
+            stopTimer();
+        }
+    }
+
+    if (released != nullptr) {
+        DBG("Releasing idle worker threads");
+    }
+}
+
+bool BackgroundScheduler::sleep (int milliseconds)
+{
+    constexpr int sliceMs = 50;
+
+    auto deadline = juce::Time::getMillisecondCounter() + (juce::uint32) juce::jmax (0, milliseconds);
+    for (;;) {
+        if (currentJobShouldExit()) {
+            return false;
+        }
+
+        auto now = juce::Time::getMillisecondCounter();
+        if (now >= deadline) {
+            return true;
+        }
+
+        juce::Thread::sleep ((int) juce::jmin ((juce::uint32) sliceMs, deadline - now));
+    }
+}
+
+bool BackgroundScheduler::currentJobShouldExit()
+{
+    auto* job = juce::ThreadPoolJob::getCurrentThreadPoolJob();
+    return job != nullptr && job->shouldExit();
+}
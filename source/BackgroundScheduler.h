@@ -0,0 +1,57 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Worker threads for network and persistence jobs, shared by every instance in
+    the process (hold it through a juce::SharedResourcePointer), so adding an
+    instance adds no threads.
+
+    Jobs are tagged with their owner. cancelJobs() drops the owner's queued jobs
+    and asks its running ones to stop, then waits for them, so an instance can be
+    destroyed safely while other instances keep using the pool. Long waits inside
+    a job should go through sleep(), which returns early once the job is cancelled.
+
+    The worker threads only exist while there is work: they are started by the
+    first submit() and released after releaseAfterIdleMs without any, so a
+    parked session costs no wakeups.
+*/
+class BackgroundScheduler : private juce::Timer
+{
+public:
+    BackgroundScheduler();
+    ~BackgroundScheduler() override;
+
+    void submit (const void* owner, const char* traceName, std::function<void()> task);
+
+    /** Removes queued jobs for owner, signals its running jobs and waits up to timeoutMs for them. */
+    bool cancelJobs (const void* owner, int timeoutMs);
+
+    /** Sleeps on the calling job's thread. Returns false if the job was cancelled meanwhile. */
+    static bool sleep (int milliseconds);
+
+    /** True if the job running on the calling thread has been asked to stop. */
+    static bool currentJobShouldExit();
+
+    /** True while the worker threads exist. */
+    bool isRunning() const;
+
+    static constexpr int numThreads = 2;
+    static constexpr int releaseAfterIdleMs = 60 * 1000;
+    static constexpr int idleCheckIntervalMs = 15 * 1000;
+
+private:
+    class Job;
+
+    juce::CriticalSection lock;
+    std::shared_ptr<juce::ThreadPool> pool;
+    juce::uint32 lastSubmissionMs = 0;
+
+    std::shared_ptr<juce::ThreadPool> getPool (bool createIfNeeded);
+    void timerCallback() override;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BackgroundScheduler)
+};
@@ -0,0 +1,234 @@
+#include <chrono>
+#include <cstdlib>
+
+#include "ClockService.h"
+
+namespace
+{
+    struct VirtualTime
+    {
+        bool enabled = false;
+        int64_t startWallMs = 0;
+        int64_t startSteadyMs = 0;
+        double speed = 1.0;
+    };
+
+    // written once by a tool before any service exists, read-only afterwards
+    VirtualTime virtualTime;
+
+    int64_t realSteadyNowMs()
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds> (std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+ClockService::ClockService() : juce::Thread ("Signalbash Clock")
+{
+    auto wall = wallNowMs();
+    publishAnchor ({ wall, steadyNowMs(), juce::Time::getCurrentTime().getUTCOffsetSeconds(), 0 });
+
+    startThread (juce::Thread::Priority::low);
+}
+
+ClockService::~ClockService()
+{
+    stopThread (1000);
+}
+
+void ClockService::useVirtualTime (int64_t startWallMs, double speed)
+{
+    jassert (speed > 0.0);
+    virtualTime = { true, startWallMs, realSteadyNowMs(), speed };
+}
+
+int64_t ClockService::steadyNowMs()
+{
+    auto real = realSteadyNowMs();
+    if (!virtualTime.enabled) {
+        return real;
+    }
+    return virtualTime.startSteadyMs + static_cast<int64_t> (static_cast<double> (real - virtualTime.startSteadyMs) * virtualTime.speed);
+}
+
+int64_t ClockService::wallNowMs()
+{
+    if (!virtualTime.enabled) {
+        return juce::Time::currentTimeMillis();
+    }
+    return virtualTime.startWallMs + (steadyNowMs() - virtualTime.startSteadyMs);
+}
+
+int ClockService::getTickIntervalMs()
+{
+    return virtualTime.enabled ? juce::jmax (1, juce::roundToInt (tickIntervalMs / virtualTime.speed)) : tickIntervalMs;
+}
+
+//==============================================================================
+int ClockService::registerWindow (int durationSeconds)
+{
+    jassert (durationSeconds > 0);
+    const juce::ScopedLock sl (registrationLock);
+
+    auto count = numWindows.load();
+    for (int i = 0; i < count; ++i) {
+        if (windows[(size_t) i].durationSeconds.load() == durationSeconds) {
+            return i;
+        }
+    }
+
+    jassert (count < maxWindows);
+    auto& window = windows[(size_t) count];
+    window.durationSeconds.store (durationSeconds);
+
+    auto nowSeconds = nowMs() / 1000;
+    window.start.store (nowSeconds - nowSeconds % durationSeconds, std::memory_order_release);
+
+    numWindows.store (count + 1, std::memory_order_release);
+    return count;
+}
+
+int64_t ClockService::nowMs() const
+{
+    return wallAt (readAnchor(), steadyNowMs());
+}
+
+int64_t ClockService::wallAt (const Anchor& anchor, int64_t steadyMs)
+{
+    auto elapsed = steadyMs - anchor.steadyMs;
+    return anchor.wallMs + elapsed + elapsed * anchor.slewPpm / 1000000;
+}
+
+int ClockService::getUTCOffsetSeconds() const
+{
+    return readAnchor().utcOffsetSeconds;
+}
+
+//==============================================================================
+void ClockService::publishAnchor (const Anchor& anchor)
+{
+    auto seq = sequence.load (std::memory_order_relaxed);
+    sequence.store (seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence (std::memory_order_release);
+
+    anchorWallMs.store (anchor.wallMs, std::memory_order_relaxed);
+    anchorSteadyMs.store (anchor.steadyMs, std::memory_order_relaxed);
+    utcOffsetSeconds.store (anchor.utcOffsetSeconds, std::memory_order_relaxed);
+    anchorSlewPpm.store (anchor.slewPpm, std::memory_order_relaxed);
+
+    sequence.store (seq + 2, std::memory_order_release);
+}
+
+ClockService::Anchor ClockService::readAnchor() const
+{
+    for (;;) {
+        auto before = sequence.load (std::memory_order_acquire);
+        if ((before & 1) != 0) {
+            continue;
+        }
+
+        Anchor anchor {
+            anchorWallMs.load (std::memory_order_relaxed),
+            anchorSteadyMs.load (std::memory_order_relaxed),
+            utcOffsetSeconds.load (std::memory_order_relaxed),
+            anchorSlewPpm.load (std::memory_order_relaxed)
+        };
+
+        std::atomic_thread_fence (std::memory_order_acquire);
+        if (sequence.load (std::memory_order_relaxed) == before) {
+            return anchor;
+        }
+    }
+}
+
+void ClockService::publishWindows (int64_t wallMs)
+{
+    auto nowSeconds = wallMs / 1000;
+    auto count = numWindows.load (std::memory_order_acquire);
+
+    for (int i = 0; i < count; ++i) {
+        auto& window = windows[(size_t) i];
+        auto duration = window.durationSeconds.load (std::memory_order_relaxed);
+        auto start = nowSeconds - nowSeconds % duration;
+
+        if (window.start.load (std::memory_order_relaxed) != start) {
+            window.start.store (start, std::memory_order_release);
+        }
+    }
+}
+
+//==============================================================================
+void ClockService::addActiveClient()
+{
+    if (activeClients.fetch_add (1, std::memory_order_acq_rel) == 0) {
+        notify();
+    }
+}
+
+void ClockService::removeActiveClient()
+{
+    activeClients.fetch_sub (1, std::memory_order_acq_rel);
+}
+
+void ClockService::run()
+{
+    while (!threadShouldExit()) {
+        if (activeClients.load (std::memory_order_acquire) <= 0) {
+            // publish before sleeping so readers stop trusting the window atomics
+            parked.store (true, std::memory_order_release);
+            wait (-1);
+            continue;
+        }
+
+        tick();
+        parked.store (false, std::memory_order_release);
+        wait (getTickIntervalMs());
+    }
+}
+
+void ClockService::tick()
+{
+    auto anchor = readAnchor();
+    auto steady = steadyNowMs();
+    auto predicted = wallAt (anchor, steady);
+    auto actual = wallNowMs();
+    auto drift = actual - predicted;
+
+    // re-anchoring at the predicted time keeps the clock continuous; only the rate changes
+    auto slewPpm = anchor.slewPpm;
+    bool reanchor = false;
+
+    if (std::llabs (drift) > discontinuityThresholdMs) {
+        discontinuities.fetch_add (1, std::memory_order_acq_rel);
+        DBG("Clock discontinuity detected: wall clock stepped by " << drift << " ms");
+        predicted = actual;
+        slewPpm = 0;
+        reanchor = true;
+    } else if (std::llabs (drift) > reanchorThresholdMs) {
+        slewPpm = drift > 0 ? maxSlewPpm : -maxSlewPpm;
+    } else if (slewPpm != 0 && (std::llabs (drift) <= slewStopMs || (drift > 0) != (slewPpm > 0))) {
+        slewPpm = 0;
+    }
+
+    if (slewPpm != anchor.slewPpm) {
+        anchor.slewPpm = slewPpm;
+        reanchor = true;
+    }
+
+    // DST and time zone changes only move the local offset; check about once a second
+    if (++ticksSinceOffsetCheck >= 1000 / getTickIntervalMs()) {
+        ticksSinceOffsetCheck = 0;
+        auto offset = juce::Time::getCurrentTime().getUTCOffsetSeconds();
+        if (offset != anchor.utcOffsetSeconds) {
+            anchor.utcOffsetSeconds = offset;
+            reanchor = true;
+        }
+    }
+
+    if (reanchor) {
+        anchor.wallMs = predicted;
+        anchor.steadyMs = steady;
+        publishAnchor (anchor);
+    }
+
+    publishWindows (predicted);
+}
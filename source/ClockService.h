@@ -0,0 +1,126 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    One wall clock for every instance in the process (hold it through a
+    juce::SharedResourcePointer).
+
+    Wall time is anchored to std::chrono::steady_clock, so readers never see it
+    jump. A background thread compares the anchor with the system clock: drift
+    up to discontinuityThresholdMs (NTP adjustments, small manual corrections)
+    is slewed away by running up to maxSlewPpm fast or slow, so time never
+    steps, backwards or forwards; anything larger (manual changes,
+    suspend/resume) is stepped to and reported as a discontinuity.
+    The anchor, its slew and the local UTC offset are published through a seqlock, and
+    the start of each registered window is published as its own atomic, so
+    window math costs a single atomic read on any thread.
+*/
+class ClockService : private juce::Thread
+{
+public:
+    ClockService();
+    ~ClockService() override;
+
+    /** Registers a window length and returns its handle. Registering the same
+        length again returns the same handle.
+    */
+    int registerWindow (int durationSeconds);
+
+    /** Start of the current window, in seconds since epoch. Single atomic read
+        while the service is ticking; computed from nowMs() while it is parked.
+    */
+    int64_t getWindowStart (int window) const
+    {
+        if (parked.load (std::memory_order_acquire)) {
+            auto duration = getWindowDuration (window);
+            auto nowSeconds = nowMs() / 1000;
+            return nowSeconds - nowSeconds % duration;
+        }
+        return windows[(size_t) window].start.load (std::memory_order_acquire);
+    }
+
+    int getWindowDuration (int window) const
+    {
+        return windows[(size_t) window].durationSeconds.load (std::memory_order_relaxed);
+    }
+
+    /** Anchored wall time in milliseconds since epoch. Never steps, in either direction, between discontinuities. */
+    int64_t nowMs() const;
+
+    int getUTCOffsetSeconds() const;
+
+    /** Clients that need the background tick. With none, the thread parks without
+        wakeups and readers compute window starts themselves; the first client to
+        return re-checks the clock straight away.
+    */
+    void addActiveClient();
+    void removeActiveClient();
+
+    /** Number of wall-clock steps detected since the service started. */
+    uint32_t getDiscontinuityCount() const { return discontinuities.load (std::memory_order_acquire); }
+
+    /** Runs every service in the process on a virtual clock that starts at
+        startWallMs and advances `speed` times faster than real time, so tools
+        can drive simulated hours of processing in minutes. The tick is sped up
+        by the same factor. Call before the first service is created; only the
+        accounting and scheduling clock is affected, network timeouts and
+        backoff stay in real time.
+    */
+    static void useVirtualTime (int64_t startWallMs, double speed);
+
+    static constexpr int maxWindows = 4;
+    static constexpr int tickIntervalMs = 100;
+    static constexpr int64_t discontinuityThresholdMs = 1000;
+    static constexpr int64_t reanchorThresholdMs = 20;  // drift that starts a slew
+    static constexpr int64_t slewStopMs = 5;            // drift at which a slew ends
+    static constexpr int64_t maxSlewPpm = 50000;        // 5%: a second of drift is gone in 20 s
+
+private:
+    struct Anchor
+    {
+        int64_t wallMs;
+        int64_t steadyMs;
+        int utcOffsetSeconds;
+        int64_t slewPpm;
+    };
+
+    struct Window
+    {
+        std::atomic<int> durationSeconds { 0 };
+        std::atomic<int64_t> start { 0 };
+    };
+
+    // seqlock: odd while the writer is mid-update
+    std::atomic<uint32_t> sequence { 0 };
+    std::atomic<int64_t> anchorWallMs { 0 };
+    std::atomic<int64_t> anchorSteadyMs { 0 };
+    std::atomic<int> utcOffsetSeconds { 0 };
+    std::atomic<int64_t> anchorSlewPpm { 0 };
+
+    std::array<Window, maxWindows> windows;
+    std::atomic<int> numWindows { 0 };
+    juce::CriticalSection registrationLock;
+
+    std::atomic<uint32_t> discontinuities { 0 };
+    std::atomic<int> activeClients { 0 };
+    std::atomic<bool> parked { false };
+    int ticksSinceOffsetCheck = 0;
+
+    void run() override;
+    void tick();
+    void publishAnchor (const Anchor& anchor);
+    Anchor readAnchor() const;
+    void publishWindows (int64_t wallMs);
+
+    static int64_t wallAt (const Anchor& anchor, int64_t steadyMs);
+    static int64_t steadyNowMs();
+    static int64_t wallNowMs();
+    static int getTickIntervalMs();
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ClockService)
+};
@@ -0,0 +1,251 @@
+#include "ConnectionMonitor.h"
+#include "RestRequest.h"
+#include "Tracer.h"
+
+#if JUCE_LINUX
+ #include <cerrno>
+ #include <fcntl.h>
+ #include <linux/netlink.h>
+ #include <linux/rtnetlink.h>
+ #include <poll.h>
+ #include <sys/socket.h>
+ #include <unistd.h>
+#endif
+
+//==============================================================================
+#if JUCE_LINUX
+/** Blocks on a netlink route socket and reports link, address and route changes. */
+class ConnectionMonitor::LinkWatcher : public juce::Thread
+{
+public:
+    static std::unique_ptr<LinkWatcher> create (ConnectionMonitor& owner)
+    {
+        int fd = socket (AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+        if (fd < 0) {
+            return nullptr;
+        }
+
+        sockaddr_nl address {};
+        address.nl_family = AF_NETLINK;
+        address.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR | RTMGRP_IPV4_ROUTE | RTMGRP_IPV6_ROUTE;
+
+        int wakePipe[2];
+        if (bind (fd, reinterpret_cast<sockaddr*> (&address), sizeof (address)) != 0 || pipe2 (wakePipe, O_CLOEXEC) != 0) {
+            close (fd);
+            return nullptr;
+        }
+
+        std::unique_ptr<LinkWatcher> watcher (new LinkWatcher (owner, fd, wakePipe[0], wakePipe[1]));
+        if (!watcher->startThread (juce::Thread::Priority::background)) {
+            return nullptr;
+        }
+
+        return watcher;
+    }
+
+    ~LinkWatcher() override
+    {
+        signalThreadShouldExit();
+        char wake = 0;
+        juce::ignoreUnused (write (wakeWrite, &wake, 1));
+        stopThread (2000);
+
+        close (netlinkFd);
+        close (wakeRead);
+        close (wakeWrite);
+    }
+
+    void run() override
+    {
+        char buffer[8192];
+
+        // no timeout: the thread costs nothing until the kernel or the destructor wakes it
+        while (!threadShouldExit()) {
+            pollfd fds[2] = { { netlinkFd, POLLIN, 0 }, { wakeRead, POLLIN, 0 } };
+            if (poll (fds, 2, -1) < 0) {
+                if (errno == EINTR) continue;
+                return;
+            }
+
+            if (fds[1].revents != 0) {
+                return;
+            }
+
+            // drain the burst a single change produces, then report it once
+            bool changed = false;
+            for (;;) {
+                auto received = recv (netlinkFd, buffer, sizeof (buffer), MSG_DONTWAIT);
+                if (received > 0) {
+                    changed = true;
+                } else {
+                    // ENOBUFS: the kernel dropped messages, which means there were changes
+                    changed = changed || (received < 0 && errno == ENOBUFS);
+                    break;
+                }
+            }
+
+            if (changed) {
+                owner.networkChanged();
+            }
+        }
+    }
+
+private:
+    LinkWatcher (ConnectionMonitor& ownerToNotify, int netlink, int readEnd, int writeEnd)
+        : juce::Thread ("Signalbash Network Watch"), owner (ownerToNotify), netlinkFd (netlink), wakeRead (readEnd), wakeWrite (writeEnd)
+    {
+    }
+
+    ConnectionMonitor& owner;
+    int netlinkFd, wakeRead, wakeWrite;
+};
+#else
+class ConnectionMonitor::LinkWatcher
+{
+public:
+    static std::unique_ptr<LinkWatcher> create (ConnectionMonitor&) { return nullptr; }
+};
+#endif
+
+//==============================================================================
+ConnectionMonitor::ConnectionMonitor() = default;
+
+ConnectionMonitor::~ConnectionMonitor()
+{
+    cancelPendingUpdate();
+    stopTimer();
+    linkWatcher = nullptr;
+    scheduler->cancelJobs (this, 5000);
+}
+
+void ConnectionMonitor::setProbeEndpoint (const std::string& url)
+{
+    {
+        const juce::ScopedLock sl (endpointLock);
+        endpoint = url;
+    }
+
+    if (!initialProbeSent.exchange (true)) {
+        probe();
+    }
+}
+
+void ConnectionMonitor::reportResponse (int status)
+{
+    setState (status > 0 ? State::healthy : State::unhealthy);
+}
+
+void ConnectionMonitor::setState (State newState)
+{
+    if (state.exchange (newState, std::memory_order_acq_rel) != newState) {
+        DBG("Connection " << (newState == State::healthy ? "healthy" : "unhealthy"));
+        SIGNALBASH_TRACE_INSTANT ("network", "connectionStateChanged");
+        triggerAsyncUpdate();
+    }
+}
+
+void ConnectionMonitor::networkChanged()
+{
+    SIGNALBASH_TRACE_INSTANT ("network", "networkChanged");
+
+    if (getState() == State::unhealthy) {
+        probeRequested.store (true, std::memory_order_release);
+        triggerAsyncUpdate();
+    }
+}
+
+void ConnectionMonitor::probe()
+{
+    if (probeInFlight.exchange (true, std::memory_order_acq_rel)) {
+        return;
+    }
+
+    std::string url;
+    {
+        const juce::ScopedLock sl (endpointLock);
+        url = endpoint;
+    }
+
+    if (url.empty()) {
+        probeInFlight.store (false, std::memory_order_release);
+        return;
+    }
+
+    // jobs are cancelled in the destructor, so capturing this is safe
+    scheduler->submit (this, "probe", [this, url] {
+        const juce::ScopeGuard clearInFlight { [this] { probeInFlight.store (false, std::memory_order_release); } };
+
+        if (!rateLimiter->acquire ([] { return BackgroundScheduler::currentJobShouldExit(); })) return;
+
+        RestRequest request;
+        RestRequest::Response response = request.get (url)
+            .expect (RestRequest::ResponseMode::statusOnly)
+            .execute();
+        rateLimiter->recordResponse (response.status, response.headers);
+
+        DBG("/ping probe => " << response.status);
+        reportResponse (response.status);
+    });
+}
+
+juce::StringArray ConnectionMonitor::getAddresses()
+{
+    juce::StringArray addresses;
+    for (const auto& address : juce::IPAddress::getAllAddresses (true)) {
+        addresses.add (address.toString());
+    }
+    addresses.sort (false);
+    return addresses;
+}
+
+void ConnectionMonitor::handleAsyncUpdate()
+{
+    if (getState() == State::unhealthy) {
+        if (!isTimerRunning()) {
+            if (linkWatcher == nullptr) {
+                linkWatcher = LinkWatcher::create (*this);
+                DBG("Network changes: " << (linkWatcher != nullptr ? "netlink" : "address polling"));
+            }
+
+            probesSinceFailure = 0;
+            nextProbeMs = juce::Time::getMillisecondCounter() + (juce::uint32) rateLimiter->getBackoffMs (1);
+            lastAddresses = getAddresses();
+            startTimer (addressPollIntervalMs);
+        }
+
+        if (probeRequested.exchange (false, std::memory_order_acq_rel)) {
+            probe();
+        }
+    } else {
+        // healthy again: no more probing, real requests keep the state current
+        stopTimer();
+        probeRequested.store (false, std::memory_order_relaxed);
+    }
+
+    sendChangeMessage();
+}
+
+void ConnectionMonitor::timerCallback()
+{
+    if (getState() != State::unhealthy) {
+        stopTimer();
+        return;
+    }
+
+    if (linkWatcher == nullptr) {
+        auto addresses = getAddresses();
+        if (addresses != lastAddresses) {
+            lastAddresses = addresses;
+            DBG("Network addresses changed");
+            probe();
+            return;
+        }
+    }
+
+    auto now = juce::Time::getMillisecondCounter();
+    if (now >= nextProbeMs && !probeInFlight.load (std::memory_order_acquire)) {
+        probe();
+        probesSinceFailure += 1;
+        nextProbeMs = now + (juce::uint32) rateLimiter->getBackoffMs (probesSinceFailure + 1);
+    }
+}
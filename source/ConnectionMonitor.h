@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <JuceHeader.h>
+#include "BackgroundScheduler.h"
+#include "RateLimiter.h"
+
+//==============================================================================
+/**
+    Process-wide reachability of the Signalbash API (hold it through a
+    juce::SharedResourcePointer), derived from the outcomes of real requests
+    rather than from pings.
+
+    Every request reports its status through reportResponse(): any HTTP status
+    means the server is reachable, a transport failure means it isn't. While
+    healthy nothing is sent on the monitor's behalf. Only once a request has
+    failed does it probe the ping endpoint, one probe at a time for the whole
+    process, with the rate limiter's backoff in between, and immediately when
+    the network configuration changes. On Linux the changes come from a
+    netlink route/link subscription; elsewhere, or if that socket can't be
+    opened, the interface addresses are polled while the connection is down.
+
+    Listeners get a change message (on the message thread) on every transition,
+    so instances can flush their backlog as soon as the connection returns.
+*/
+class ConnectionMonitor : public juce::ChangeBroadcaster,
+                          private juce::Timer,
+                          private juce::AsyncUpdater
+{
+public:
+    enum class State
+    {
+        unknown,
+        healthy,
+        unhealthy
+    };
+
+    ConnectionMonitor();
+    ~ConnectionMonitor() override;
+
+    /** Where probes go. The first call probes once, so the state doesn't stay unknown. */
+    void setProbeEndpoint (const std::string& url);
+
+    /** Feeds a request's outcome in, from any thread. 0 is a transport failure. */
+    void reportResponse (int status);
+
+    State getState() const noexcept { return state.load (std::memory_order_acquire); }
+
+    /** Optimistic: true until a request has actually failed. */
+    bool isHealthy() const noexcept { return getState() != State::unhealthy; }
+
+    /** The network configuration changed; probes right away if the connection is down. Any thread. */
+    void networkChanged();
+
+    static constexpr int addressPollIntervalMs = 2000;
+
+private:
+    class LinkWatcher;
+
+    std::atomic<State> state { State::unknown };
+    std::atomic<bool> probeInFlight { false };
+    std::atomic<bool> probeRequested { false };
+    std::atomic<bool> initialProbeSent { false };
+
+    juce::CriticalSection endpointLock;
+    std::string endpoint;
+
+    // message thread only
+    int probesSinceFailure = 0;
+    juce::uint32 nextProbeMs = 0;
+    juce::StringArray lastAddresses;
+    std::unique_ptr<LinkWatcher> linkWatcher;
+
+    juce::SharedResourcePointer<BackgroundScheduler> scheduler;
+    juce::SharedResourcePointer<RateLimiter> rateLimiter;
+
+    void setState (State newState);
+    void probe();
+    static juce::StringArray getAddresses();
+
+    void handleAsyncUpdate() override;
+    void timerCallback() override;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ConnectionMonitor)
+};
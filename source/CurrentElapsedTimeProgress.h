@@ -2,68 +2,50 @@
 
 #include <cstdint>
 #include <JuceHeader.h>
+#include "ClockService.h"
 
+/** A fixed-length window over the process-wide ClockService. Holds no time state
+    of its own: every read goes to the service, so all instances agree on window
+    boundaries and reads are safe from any thread.
+*/
 class CurrentElapsedTimeProgress
 {
 public:
-    CurrentElapsedTimeProgress(int totalDurSeconds) : totalDurationSeconds(totalDurSeconds)
+    CurrentElapsedTimeProgress(int totalDurSeconds)
+        : totalDurationSeconds(totalDurSeconds), window(clock->registerWindow(totalDurSeconds))
     {
-        _totalDurationSeconds64 = static_cast<int64_t>(totalDurationSeconds);
-        localTimezoneOffsetSeconds = juce::Time::getCurrentTime().getUTCOffsetSeconds();
-
         totalDurationSecondsInvert = 1.0 / static_cast<double>(totalDurationSeconds);
-
-        update();
-    }
-
-    void update() {
-
-        nowTimeStamp = juce::Time::currentTimeMillis() * oneThouInvert;
-
-        std::lldiv_t divmod = std::lldiv(nowTimeStamp, _totalDurationSeconds64);
-
-        progress = 100.0 * ( static_cast<double>(divmod.rem) * totalDurationSecondsInvert);
-
-        if (divmod.quot != blockNumber) {
-            blockNumber = divmod.quot;
-            blockTimestamp = divmod.quot * totalDurationSeconds;
-        }
     }
 
-    juce::String getCurrentUTCDateAsString () {
-        auto now = juce::Time::getCurrentTime();
-        auto offset = juce::RelativeTime::seconds(localTimezoneOffsetSeconds);
+    juce::String getCurrentUTCDateAsString () const {
+        auto now = juce::Time(clock->nowMs());
+        auto offset = juce::RelativeTime::seconds(clock->getUTCOffsetSeconds());
         auto currTime = now - offset;
         return currTime.formatted("%Y-%m-%d %H:%M:%S");
     }
 
-    juce::String getCurrentLocalDateTimeAsString () {
-        return juce::Time::getCurrentTime().formatted("%Y-%m-%d %H:%M:%S");
+    juce::String getCurrentLocalDateTimeAsString () const {
+        return juce::Time(clock->nowMs()).formatted("%Y-%m-%d %H:%M:%S");
     }
 
-    std::string getTimestamp () {
-        return std::to_string(juce::Time::currentTimeMillis() / 1000);
+    std::string getTimestamp () const {
+        return std::to_string(clock->nowMs() / 1000);
     }
 
-    void recalcLocalOffset () {
-        localTimezoneOffsetSeconds = juce::Time::getCurrentTime().getUTCOffsetSeconds();
+    double getProgress() const {
+        auto elapsedMs = clock->nowMs() - getCurrentBlockTimestamp() * 1000;
+        return juce::jlimit(0.0, 100.0, 0.1 * static_cast<double>(elapsedMs) * totalDurationSecondsInvert);
     }
 
-    double getProgress() const { return progress; }
+    int64_t getCurrentBlock () const { return getCurrentBlockTimestamp() / totalDurationSeconds; }
+    int64_t getCurrentBlockTimestamp () const { return clock->getWindowStart(window); }
 
-    int64_t getCurrentBlock () const { return blockNumber; }
-    int64_t getCurrentBlockTimestamp () const { return blockTimestamp; }
+    int64_t nowMs () const { return clock->nowMs(); }
+    uint32_t getDiscontinuityCount () const { return clock->getDiscontinuityCount(); }
 
 private:
+    juce::SharedResourcePointer<ClockService> clock;
     int totalDurationSeconds;
-    int64_t _totalDurationSeconds64;
-    int localTimezoneOffsetSeconds;
-    double progress = 0.0;
-    int64_t blockTimestamp = 0;
-    int64_t blockNumber = 0;
-
-    double oneThouInvert = 0.001;
+    int window;
     double totalDurationSecondsInvert;
-
-    int64_t nowTimeStamp = juce::Time::getCurrentTime().toMilliseconds() / 1000;
 };
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <thread>
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Process-wide generator for 128-bit deduplication IDs and the per-window
+    idempotency keys attached to each submission.
+
+    The 128-bit process key is drawn once from std::random_device, then every ID
+    is produced by mixing that key with an atomic counter, so plugin instances
+    constructed in parallel never share a sequence and never take a lock.
+*/
+class DeduplicationID
+{
+public:
+    /** Returns a new 32 character hex ID, unique within and across processes. */
+    static std::string generate()
+    {
+        const auto& key = getProcessKey();
+        const auto n = getCounter().fetch_add(1, std::memory_order_relaxed);
+
+        const auto hi = mix(key[0] ^ mix(n));
+        const auto lo = mix(key[1] + n * goldenGamma);
+
+        return toHex(hi, lo);
+    }
+
+    /** Returns the idempotency key for one activity window of one instance.
+
+        The key is a pure function of its inputs, so every retry of the same
+        window carries the same key and the server can drop the duplicates.
+    */
+    static std::string idempotencyKey(const std::string& instanceID, int64_t windowTimestamp)
+    {
+        const auto h = hashString(instanceID);
+        const auto w = static_cast<uint64_t>(windowTimestamp);
+
+        return toHex(mix(h ^ mix(w)), mix(h + w * goldenGamma + 1));
+    }
+
+    /** Returns the idempotency key for a bucket of merged windows starting at
+        bucketTimestamp. It differs from the key of a window with that timestamp,
+        so a bucket is never dropped as a retry of a window already accepted.
+    */
+    static std::string idempotencyKey(const std::string& instanceID, int64_t bucketTimestamp, int bucketSeconds)
+    {
+        return idempotencyKey(instanceID + "/" + std::to_string(bucketSeconds), bucketTimestamp);
+    }
+
+    /** Folds a set of window keys into one key for the whole request. The
+        result does not depend on the order in which the keys are added.
+    */
+    class BatchKey
+    {
+    public:
+        void add(const std::string& windowKey)
+        {
+            const auto h = hashString(windowKey);
+            acc[0] += mix(h);
+            acc[1] ^= mix(h + goldenGamma);
+        }
+
+        std::string toString() const { return toHex(mix(acc[0]), mix(acc[1])); }
+
+    private:
+        std::array<uint64_t, 2> acc {0, 0};
+    };
+
+private:
+    static constexpr uint64_t goldenGamma = 0x9E3779B97F4A7C15ull;
+
+    // SplitMix64 finaliser
+    static uint64_t mix(uint64_t x)
+    {
+        x += goldenGamma;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+    }
+
+    // FNV-1a
+    static uint64_t hashString(const std::string& s)
+    {
+        uint64_t h = 0xCBF29CE484222325ull;
+        for (auto c : s) {
+            h ^= static_cast<unsigned char>(c);
+            h *= 0x100000001B3ull;
+        }
+        return h;
+    }
+
+    static std::string toHex(uint64_t hi, uint64_t lo)
+    {
+        static const char digits[] = "0123456789abcdef";
+        std::string result(32, '0');
+        for (int i = 0; i < 16; ++i) {
+            result[15 - i] = digits[hi & 0xF]; hi >>= 4;
+            result[31 - i] = digits[lo & 0xF]; lo >>= 4;
+        }
+        return result;
+    }
+
+    static const std::array<uint64_t, 2>& getProcessKey()
+    {
+        // Initialised exactly once per process (C++11 guarantees a thread-safe static init).
+        static const std::array<uint64_t, 2> key = []
+        {
+            std::random_device rd;
+            auto next64 = [&rd] { return (static_cast<uint64_t>(rd()) << 32) ^ rd(); };
+
+            // random_device may be deterministic on some toolchains, so fold in
+            // sources that differ between processes and between launches.
+            const auto clock = static_cast<uint64_t>(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+            const auto thread = static_cast<uint64_t>(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+            const auto address = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(&rd));
+
+            return std::array<uint64_t, 2> {
+                mix(next64() ^ clock ^ static_cast<uint64_t>(juce::Time::getHighResolutionTicks())),
+                mix(next64() ^ thread ^ (address << 1))
+            };
+        }();
+        return key;
+    }
+
+    static std::atomic<uint64_t>& getCounter()
+    {
+        static std::atomic<uint64_t> counter {0};
+        return counter;
+    }
+};
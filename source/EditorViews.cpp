@@ -0,0 +1,500 @@
+#include "EditorViews.h"
+#include "Tracer.h"
+
+const juce::Colour EditorView::buttonFillColor { 0xFF222426 };
+
+void EditorView::styleButton (juce::TextButton& button, const juce::String& text, juce::Button::Listener* listener)
+{
+    addAndMakeVisible(button);
+    button.setButtonText(text);
+    button.addListener(listener);
+    button.setColour(juce::TextButton::buttonColourId, buttonFillColor);
+}
+
+//==============================================================================
+SessionKeyView::SessionKeyView (SignalbashAudioProcessor& p, Navigator navigator)
+    : EditorView (p, std::move (navigator))
+{
+    addAndMakeVisible(sessionKeyLabel);
+    sessionKeyLabel.setText("Enter Session Key:", juce::dontSendNotification);
+
+    addAndMakeVisible(sessionKeyEditor);
+    sessionKeyEditor.setPasswordCharacter('*');
+    sessionKeyEditor.setJustification(juce::Justification::centred);
+    sessionKeyEditor.setTextToShowWhenEmpty("Session Key", juce::Colours::grey);
+    sessionKeyEditor.setColour(juce::TextEditor::backgroundColourId, buttonFillColor);
+
+    styleButton(submitSessionKeyButton, "Submit", this);
+    styleButton(editSessionKeyCancelButton, "Cancel", this);
+    editSessionKeyCancelButton.setVisible(!audioProcessor.sessionKey.isEmpty());
+
+    if (!audioProcessor.isCurrentSessionKeyValidated()) {
+        sessionKeyEditor.setText(audioProcessor.sessionKey, false);
+    }
+}
+
+void SessionKeyView::paint (juce::Graphics& g)
+{
+    SIGNALBASH_TRACE_SCOPE("ui", "sessionKeyViewPaint");
+    g.setColour (juce::Colours::white);
+    g.setFont (18.0f);
+
+    if (audioProcessor.sessionKey.isEmpty()) {
+        g.drawFittedText("Get your session key by logging into your account at signalbash.com",
+                         100, 150 + 10,
+                         200, 40,
+                         juce::Justification::centred, 3
+                         );
+    }
+
+    updateSplashImage(g.getInternalContext().getPhysicalPixelScaleFactor());
+    g.drawImageWithin(splashLogoImage,
+                      splashBounds.getX(), splashBounds.getY(), splashBounds.getWidth(), splashBounds.getHeight(),
+                      juce::RectanglePlacement::xMid);
+}
+
+void SessionKeyView::resized()
+{
+    auto area = getLocalBounds();
+    area.removeFromTop(110);
+    area.removeFromLeft(20);
+    area.removeFromRight(20);
+    sessionKeyLabel.setBounds(area.removeFromTop(20));
+    sessionKeyEditor.setBounds(area.removeFromTop(20));
+    area.removeFromTop(5);
+    submitSessionKeyButton.setBounds(area.removeFromTop(20));
+    editSessionKeyCancelButton.setBounds(getLocalBounds().removeFromBottom(40).reduced(10));
+}
+
+void SessionKeyView::visibilityChanged()
+{
+    if (!isVisible()) {
+        splashLogoImage = {};
+    }
+}
+
+void SessionKeyView::updateSplashImage (float scale)
+{
+    if (splashLogoImage.isValid() && juce::approximatelyEqual(splashScale, scale)) {
+        return;
+    }
+
+    // the source is 990x624; decode it, keep a copy at the size it is drawn at
+    // and let the full-size image go straight away
+    auto full = juce::ImageFileFormat::loadFrom(BinaryData::signalbash_logo_text_990x624_png,
+                                                BinaryData::signalbash_logo_text_990x624_pngSize);
+    if (!full.isValid()) {
+        return;
+    }
+
+    auto target = juce::RectanglePlacement(juce::RectanglePlacement::xMid)
+                      .appliedTo(full.getBounds().toFloat(), splashBounds.toFloat());
+
+    splashLogoImage = full.rescaled(juce::jmax(1, juce::roundToInt(target.getWidth() * scale)),
+                                    juce::jmax(1, juce::roundToInt(target.getHeight() * scale)),
+                                    juce::Graphics::highResamplingQuality);
+    splashScale = scale;
+}
+
+void SessionKeyView::buttonClicked (juce::Button* button)
+{
+    if (button == &submitSessionKeyButton) {
+        juce::String newSessionKey = sessionKeyEditor.getText().trim().removeCharacters("-");
+        if (newSessionKey.isEmpty() || newSessionKey.length() < 12) {
+            DBG("Invalid Session Key");
+            return;
+        }
+        DBG("Session Key Submitted: " << newSessionKey);
+        audioProcessor.setSessionKey(newSessionKey);
+        showView(Type::main);
+        return;
+    }
+
+    if (button == &editSessionKeyCancelButton) {
+        showView(Type::settings);
+        return;
+    }
+}
+
+//==============================================================================
+LevelMeterComponent::LevelMeterComponent (SignalbashAudioProcessor& p)
+    : audioProcessor (p)
+{
+    rmsDb.fill(minDb);
+    peakDb.fill(minDb);
+    setInterceptsMouseClicks(false, false);
+    audioProcessor.levelMeter.setEnabled(true);
+}
+
+LevelMeterComponent::~LevelMeterComponent()
+{
+    audioProcessor.levelMeter.setEnabled(false);
+}
+
+void LevelMeterComponent::paint (juce::Graphics& g)
+{
+    SIGNALBASH_TRACE_SCOPE("ui", "levelMeterPaint");
+    auto bars = getBarArea();
+    g.setColour(EditorView::buttonFillColor);
+    g.fillRect(bars);
+
+    if (numChannels > 0) {
+        auto rowHeight = bars.getHeight() / numChannels;
+        for (int channel = 0; channel < numChannels; ++channel) {
+            auto row = bars.withHeight(rowHeight).translated(0, channel * rowHeight).reduced(0, 1);
+            g.setColour(active ? juce::Colours::limegreen : juce::Colours::grey);
+            g.fillRect(row.withWidth(toPixels(rmsDb[(size_t) channel])));
+            g.setColour(juce::Colours::white);
+            g.fillRect(row.getX() + juce::jmax(0, toPixels(peakDb[(size_t) channel]) - 2), row.getY(), 2, row.getHeight());
+        }
+    }
+
+    g.setColour(juce::Colours::orange);
+    g.fillRect(bars.getX() + toPixels(static_cast<float>(audioProcessor.minDbThreshold)), bars.getY(), 1, bars.getHeight());
+
+    // oldest cell on the left
+    auto strip = getLocalBounds().removeFromBottom(timelineHeight).toFloat();
+    auto cellWidth = strip.getWidth() / timelineCells;
+    for (int cell = 0; cell < timelineCells; ++cell) {
+        auto wasActive = timeline[(size_t) ((timelineHead + cell) % timelineCells)];
+        g.setColour(wasActive ? juce::Colours::limegreen : EditorView::buttonFillColor);
+        g.fillRect(strip.withX(strip.getX() + cell * cellWidth).withWidth(cellWidth - 1.0f));
+    }
+}
+
+void LevelMeterComponent::tick()
+{
+    const auto fresh = audioProcessor.levelMeter.read(snapshot);
+    if (fresh) {
+        numChannels = snapshot.numChannels;
+        active = snapshot.active;
+        cellActive = cellActive || snapshot.active;
+        staleTicks = 0;
+    } else if (++staleTicks > 6) {
+        // nothing processed for ~100 ms: the host stopped calling us
+        active = false;
+    }
+
+    // a new block sets the bars; between blocks they fall, peaks slower than RMS
+    for (size_t channel = 0; channel < LevelMeter::maxChannels; ++channel) {
+        auto inBlock = fresh && (int) channel < numChannels;
+        auto rms = inBlock ? juce::Decibels::gainToDecibels(snapshot.rms[channel], minDb) : minDb;
+        auto peak = inBlock ? juce::Decibels::gainToDecibels(snapshot.peak[channel], minDb) : minDb;
+        rmsDb[channel] = fresh ? rms : juce::jmax(minDb, rmsDb[channel] - 4.0f * peakFalloffDbPerTick);
+        peakDb[channel] = juce::jmax(peak, peakDb[channel] - peakFalloffDbPerTick);
+    }
+
+    auto timelineMoved = false;
+    if (++ticksInCell >= ticksPerTimelineCell) {
+        timeline[(size_t) timelineHead] = cellActive;
+        timelineHead = (timelineHead + 1) % timelineCells;
+        ticksInCell = 0;
+        cellActive = false;
+        timelineMoved = true;
+    }
+
+    auto pixels = getPixels();
+    if (timelineMoved || pixels != drawnPixels) {
+        drawnPixels = pixels;
+        repaint();
+    }
+}
+
+juce::Rectangle<int> LevelMeterComponent::getBarArea() const
+{
+    return getLocalBounds().withTrimmedBottom(timelineHeight + 2);
+}
+
+int LevelMeterComponent::toPixels (float db) const
+{
+    auto width = getBarArea().getWidth();
+    return juce::jlimit(0, width, juce::roundToInt(juce::jmap(juce::jlimit(minDb, 0.0f, db), minDb, 0.0f, 0.0f, static_cast<float>(width))));
+}
+
+LevelMeterComponent::PixelState LevelMeterComponent::getPixels() const
+{
+    PixelState pixels {};
+    pixels[0] = numChannels;
+    pixels[1] = active ? 1 : 0;
+    for (size_t channel = 0; channel < LevelMeter::maxChannels; ++channel) {
+        pixels[2 + 2 * channel] = toPixels(rmsDb[channel]);
+        pixels[3 + 2 * channel] = toPixels(peakDb[channel]);
+    }
+    return pixels;
+}
+
+//==============================================================================
+MainView::MainView (SignalbashAudioProcessor& p, Navigator navigator)
+    : EditorView (p, std::move (navigator)), levelMeter (p)
+{
+    rotatingImage = juce::ImageCache::getFromMemory(BinaryData::signalbash_logo_100x_png, BinaryData::signalbash_logo_100x_pngSize);
+    addAndMakeVisible(levelMeter);
+
+    styleButton(retrySessionKeyValidateButton, "Session Key Not Yet Validated - Retry", this);
+    retrySessionKeyValidateButton.setVisible(shouldShowRetry());
+}
+
+void MainView::paint (juce::Graphics& g)
+{
+    SIGNALBASH_TRACE_SCOPE("ui", "mainViewPaint");
+    float centerX = getWidth() / 2.0f;
+    float centerY = getHeight() / 2.0f;
+
+    float halfWidth = rotatingImage.getWidth() / 2.0f;
+    float halfHeight = rotatingImage.getHeight() / 2.0f;
+
+    juce::AffineTransform transform;
+
+    transform = juce::AffineTransform::translation(-halfWidth, -halfHeight);
+
+    if (audioProcessor.controlState.enableAnimation.load(std::memory_order_relaxed)) {
+        transform = transform.rotated(juce::degreesToRadians(rotationAngle));
+    }
+
+    transform = transform.translated(centerX, centerY);
+
+    g.drawImageTransformed(rotatingImage, transform, false);
+
+    g.setColour (juce::Colours::grey);
+    g.setFont (juce::FontOptions (14.0f));
+    g.drawFittedText ("Today: " + formatDuration (audioProcessor.historyStore->getTodayMilliseconds())
+                      + "    This Week: " + formatDuration (audioProcessor.historyStore->getThisWeekMilliseconds()),
+                      0, 10, getWidth(), 20,
+                      juce::Justification::centred, 1);
+}
+
+void MainView::resized()
+{
+    retrySessionKeyValidateButton.setBounds(getLocalBounds().removeFromBottom(40).reduced(10));
+    // between the spinner's sweep and the retry button
+    levelMeter.setBounds(40, getHeight() - 62, getWidth() - 80, 22);
+}
+
+void MainView::mouseDown (const juce::MouseEvent& event)
+{
+    if (spinnerBounds.contains(event.position)) {
+        rotationAngle = 0.0f;
+        repaint();
+    }
+}
+
+void MainView::tick()
+{
+    if (++historyRefreshCountdown >= 60) {
+        historyRefreshCountdown = 0;
+        audioProcessor.historyStore->refresh();
+        repaint(0, 10, getWidth(), 20);
+    }
+
+    if (audioProcessor.controlState.enableAnimation.load(std::memory_order_relaxed) && audioProcessor.audioState.signalHot.load(std::memory_order_relaxed)) {
+        rotationAngle += 2.0f;
+        if (rotationAngle >= 360.0f) {
+            rotationAngle -= 360.0f;
+        }
+
+        // the rotated 100px logo stays within its circumscribed square
+        auto diagonal = juce::roundToInt(std::ceil(rotatingImage.getBounds().toFloat().getDiagonal()));
+        repaint(juce::Rectangle<int>(diagonal, diagonal).withCentre(getLocalBounds().getCentre()));
+    }
+
+    levelMeter.tick();
+    retrySessionKeyValidateButton.setVisible(shouldShowRetry());
+}
+
+bool MainView::shouldShowRetry() const
+{
+    const auto& control = audioProcessor.controlState;
+    auto validated = control.sessionKeyValidated.load(std::memory_order_relaxed);
+    return (!control.connectionHealthy.load(std::memory_order_relaxed) && !validated) ||
+           (!control.currentSessionKeyInvalid.load(std::memory_order_relaxed) && !validated && audioProcessor.sessionKey.isEmpty());
+}
+
+void MainView::buttonClicked (juce::Button* button)
+{
+    if (button == &retrySessionKeyValidateButton) {
+        audioProcessor.validateSessionKey();
+    }
+}
+
+juce::String MainView::formatDuration (int64_t milliseconds)
+{
+    auto totalMinutes = milliseconds / 60000;
+    return juce::String (totalMinutes / 60) + "h " + juce::String (totalMinutes % 60).paddedLeft ('0', 2) + "m";
+}
+
+//==============================================================================
+SettingsView::SettingsView (SignalbashAudioProcessor& p, Navigator navigator, bool debugMode)
+    : EditorView (p, std::move (navigator)), settingsDebugMode (debugMode)
+{
+    styleButton(copySessionKeyButton, "Copy Session Key", this);
+    styleButton(changeSessionKeyButton, "Change Session Key", this);
+
+    addAndMakeVisible(animationActiveToggle);
+    animationActiveToggle.setToggleState(audioProcessor.controlState.enableAnimation.load(std::memory_order_relaxed), juce::dontSendNotification);
+    animationActiveToggle.setButtonText("Enable Animation");
+    animationActiveToggle.addListener(this);
+
+    if (settingsDebugMode) {
+        styleButton(flushButton, "FLUSH", this);
+        styleButton(traceButton, Tracer::isEnabled() ? "STOP TRACE" : "START TRACE", this);
+        styleButton(exportTraceButton, "EXPORT TRACE", this);
+        styleButton(captureButton, audioProcessor.capture.isCapturing() ? "STOP CAPTURE" : "CAPTURE", this);
+    }
+}
+
+void SettingsView::paint (juce::Graphics& g)
+{
+    SIGNALBASH_TRACE_SCOPE("ui", "settingsViewPaint");
+    g.setColour (juce::Colours::white);
+
+    auto bounds = getLocalBounds();
+    bounds.removeFromTop(10); bounds.removeFromLeft(40); bounds.removeFromRight(40);
+
+    g.setFont (juce::FontOptions (17.0f));
+
+    g.drawFittedText(settingsDebugMode ? "Settings (debug mode) - v" + audioProcessor._PLUGIN_VERSION  : "Settings",
+                     bounds.removeFromTop(30),
+                     juce::Justification::centredLeft, 1
+                     );
+    bounds.removeFromTop(5);
+    g.setFont (juce::FontOptions (15.0f));
+    g.drawFittedText("Host: " + audioProcessor.hostNameDisplay,
+                     bounds.removeFromTop(20),
+                     juce::Justification::centredLeft, 1);
+    if (settingsDebugMode) {
+        g.drawFittedText("Current Time (UTC): " + audioProcessor.submissionWindowTimer.getCurrentUTCDateAsString(),
+                         bounds.removeFromTop(20),
+                         juce::Justification::centredLeft, 1);
+        g.drawFittedText ("Pending Activity: " + juce::String(audioProcessor.audioState.activity.load(std::memory_order_relaxed)),
+                          bounds.removeFromTop(20),
+                          juce::Justification::centredLeft, 1);
+        if (InstrumentedCriticalSection::statsEnabled) {
+            auto lockStats = audioProcessor.mutex.getStats();
+            g.drawFittedText ("Lock: " + juce::String(lockStats.acquisitions) + " taken, "
+                              + juce::String(lockStats.contended) + " contended, max hold "
+                              + juce::String(lockStats.maxHoldMicroseconds, 1) + " us",
+                              bounds.removeFromTop(20),
+                              juce::Justification::centredLeft, 1);
+        }
+    }
+    g.drawFittedText ("Session Key: " + getObfuscatedSessionKey().toUpperCase(),
+                      bounds.removeFromTop(20),
+                      juce::Justification::centredLeft, 1);
+
+    g.drawFittedText ("Animation:",
+                      bounds.removeFromTop(90),
+                      juce::Justification::centredLeft, 1);
+
+    lastProgressWidth = static_cast<int>(getWidth() * audioProcessor.getSubmissionProgress() / 100);
+    g.fillRect(0, 0, lastProgressWidth, 2);
+}
+
+void SettingsView::resized()
+{
+    auto bounds = getLocalBounds();
+    bounds.removeFromTop(10);
+    bounds.removeFromLeft(40);
+    bounds.removeFromRight(40);
+    bounds.removeFromTop(30);
+    bounds.removeFromTop(5);
+    bounds.removeFromTop(20);
+    if (settingsDebugMode) {
+        bounds.removeFromTop(20);
+        bounds.removeFromTop(20);
+        if (InstrumentedCriticalSection::statsEnabled) {
+            bounds.removeFromTop(20);
+        }
+    }
+    bounds.removeFromTop(20);
+    auto sessKeyBounds = bounds.removeFromTop(20);
+    copySessionKeyButton.setBounds(sessKeyBounds.removeFromLeft(sessKeyBounds.getWidth() / 2));
+    changeSessionKeyButton.setBounds(sessKeyBounds);
+    bounds.removeFromTop(40);
+    animationActiveToggle.setBounds(bounds.removeFromTop(20));
+
+    auto debugRow = getLocalBounds().removeFromBottom(40).reduced(10);
+    auto buttonWidth = debugRow.getWidth() / 4;
+    flushButton.setBounds(debugRow.removeFromLeft(buttonWidth).reduced(2, 0));
+    traceButton.setBounds(debugRow.removeFromLeft(buttonWidth).reduced(2, 0));
+    exportTraceButton.setBounds(debugRow.removeFromLeft(buttonWidth).reduced(2, 0));
+    captureButton.setBounds(debugRow.reduced(2, 0));
+}
+
+void SettingsView::tick()
+{
+    if (settingsDebugMode) {
+        // clock and pending activity change continuously
+        repaint();
+        return;
+    }
+
+    auto progressWidth = static_cast<int>(getWidth() * audioProcessor.getSubmissionProgress() / 100);
+    if (progressWidth != lastProgressWidth) {
+        repaint(0, 0, getWidth(), 2);
+    }
+}
+
+void SettingsView::buttonClicked (juce::Button* button)
+{
+    if (button == &flushButton) {
+        audioProcessor.flushAccumulator();
+        return;
+    }
+
+    if (button == &traceButton) {
+        Tracer::setEnabled(!Tracer::isEnabled());
+        traceButton.setButtonText(Tracer::isEnabled() ? "STOP TRACE" : "START TRACE");
+        return;
+    }
+
+    if (button == &exportTraceButton) {
+        auto traceFile = Tracer::getDefaultExportFile();
+        auto result = Tracer::exportChromeJSON(traceFile);
+        if (result.wasOk()) {
+            traceFile.revealToUser();
+        } else {
+            juce::AlertWindow::showMessageBoxAsync(juce::AlertWindow::WarningIcon, "Trace Export", result.getErrorMessage());
+        }
+        return;
+    }
+
+    if (button == &captureButton) {
+        audioProcessor.toggleEnvelopeCapture();
+        captureButton.setButtonText(audioProcessor.capture.isCapturing() ? "STOP CAPTURE" : "CAPTURE");
+        return;
+    }
+
+    if (button == &animationActiveToggle) {
+        DBG("animationActiveToggle pressed");
+        audioProcessor.toggleAnimationEnabled(button->getToggleState());
+        return;
+    }
+
+    if (button == &copySessionKeyButton) {
+        juce::SystemClipboard::copyTextToClipboard(audioProcessor.sessionKey.toUpperCase());
+        DBG("Copied To Clipboard");
+        juce::AlertWindow::showMessageBoxAsync(juce::AlertWindow::InfoIcon, "Info", "Copied Session Key");
+        return;
+    }
+
+    if (button == &changeSessionKeyButton) {
+        showView(Type::sessionKeyEnter);
+        return;
+    }
+}
+
+juce::String SettingsView::getObfuscatedSessionKey() const
+{
+    auto sessionKey = audioProcessor.sessionKey;
+
+    if (sessionKey.length() <= 8)
+        return sessionKey;
+
+    auto firstFour = sessionKey.substring(0, 4);
+    auto lastFour = sessionKey.substring(sessionKey.length() - 4);
+
+    auto middleLength = sessionKey.length() - 8;
+    juce::String middleBullets = juce::String::repeatedString("•", middleLength);
+
+    return firstFour + middleBullets + lastFour;
+}
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <array>
+#include <functional>
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+//==============================================================================
+/**
+    Base for the editor's views. Only the visible view exists: the editor builds
+    it when it is shown and destroys it when another view replaces it, so a view's
+    widgets and images cost nothing while it is hidden. Views sit below the status
+    bar and lay themselves out in resized(); tick() is driven by the editor timer
+    and should only repaint what actually changed.
+*/
+class EditorView : public juce::Component
+{
+public:
+    enum class Type
+    {
+        sessionKeyEnter,
+        main,
+        settings
+    };
+
+    using Navigator = std::function<void (Type)>;
+
+    EditorView (SignalbashAudioProcessor& p, Navigator navigator)
+        : audioProcessor (p), showView (std::move (navigator))
+    {
+    }
+
+    virtual void tick() {}
+
+    static const juce::Colour buttonFillColor;
+
+protected:
+    SignalbashAudioProcessor& audioProcessor;
+
+    // switching views destroys this one, so call it last
+    Navigator showView;
+
+    void styleButton (juce::TextButton& button, const juce::String& text, juce::Button::Listener* listener);
+};
+
+//==============================================================================
+class SessionKeyView : public EditorView,
+                       private juce::Button::Listener
+{
+public:
+    SessionKeyView (SignalbashAudioProcessor&, Navigator);
+
+    void paint (juce::Graphics&) override;
+    void resized() override;
+    void visibilityChanged() override;
+
+private:
+    void buttonClicked (juce::Button* button) override;
+    void updateSplashImage (float scale);
+
+    juce::Label sessionKeyLabel;
+    juce::TextEditor sessionKeyEditor;
+    juce::TextButton submitSessionKeyButton;
+    juce::TextButton editSessionKeyCancelButton;
+
+    // decoded at display size while visible; the full-size splash is never kept
+    juce::Image splashLogoImage;
+    float splashScale = 0.0f;
+    const juce::Rectangle<int> splashBounds { 112, 10, 175, 90 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SessionKeyView)
+};
+
+//==============================================================================
+/**
+    Input level per channel (RMS bar, peak marker, detector threshold line)
+    over a strip of recent activity, drawn from the processor's LevelMeter.
+    Metering is switched on for as long as this component exists. tick()
+    repaints only this component, and only when a drawn pixel would move.
+*/
+class LevelMeterComponent : public juce::Component
+{
+public:
+    explicit LevelMeterComponent (SignalbashAudioProcessor&);
+    ~LevelMeterComponent() override;
+
+    void paint (juce::Graphics&) override;
+    void tick();
+
+private:
+    static constexpr float minDb = -72.0f;
+    static constexpr float peakFalloffDbPerTick = 0.5f;
+    static constexpr int timelineCells = 60;
+    static constexpr int ticksPerTimelineCell = 30;   // half a second at the editor's 60 Hz
+    static constexpr int timelineHeight = 6;
+
+    SignalbashAudioProcessor& audioProcessor;
+    LevelMeter::Snapshot snapshot;
+
+    int numChannels = 0;
+    std::array<float, LevelMeter::maxChannels> rmsDb;
+    std::array<float, LevelMeter::maxChannels> peakDb;
+    bool active = false;
+
+    // ring of per-cell verdicts, oldest at timelineHead
+    std::array<bool, timelineCells> timeline {};
+    int timelineHead = 0;
+    int ticksInCell = 0;
+    bool cellActive = false;
+
+    // everything paint() draws from, in pixels; a tick only repaints when this changes
+    using PixelState = std::array<int, 2 * LevelMeter::maxChannels + 2>;
+    PixelState drawnPixels {};
+    int staleTicks = 0;
+
+    juce::Rectangle<int> getBarArea() const;
+    int toPixels (float db) const;
+    PixelState getPixels() const;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LevelMeterComponent)
+};
+
+//==============================================================================
+class MainView : public EditorView,
+                 private juce::Button::Listener
+{
+public:
+    MainView (SignalbashAudioProcessor&, Navigator);
+
+    void paint (juce::Graphics&) override;
+    void resized() override;
+    void mouseDown (const juce::MouseEvent& event) override;
+    void tick() override;
+
+private:
+    void buttonClicked (juce::Button* button) override;
+    bool shouldShowRetry() const;
+
+    juce::TextButton retrySessionKeyValidateButton;
+    LevelMeterComponent levelMeter;
+
+    juce::Image rotatingImage;
+    float rotationAngle = 0.0f;
+    juce::Rectangle<float> spinnerBounds { 165, 70, 100, 100 };
+
+    int historyRefreshCountdown = 0;
+
+    static juce::String formatDuration (int64_t milliseconds);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MainView)
+};
+
+//==============================================================================
+class SettingsView : public EditorView,
+                     private juce::Button::Listener
+{
+public:
+    SettingsView (SignalbashAudioProcessor&, Navigator, bool debugMode);
+
+    void paint (juce::Graphics&) override;
+    void resized() override;
+    void tick() override;
+
+private:
+    void buttonClicked (juce::Button* button) override;
+    juce::String getObfuscatedSessionKey() const;
+
+    const bool settingsDebugMode;
+
+    juce::TextButton flushButton;
+    juce::TextButton traceButton;
+    juce::TextButton exportTraceButton;
+    juce::TextButton captureButton;
+    juce::TextButton copySessionKeyButton;
+    juce::TextButton changeSessionKeyButton;
+    juce::ToggleButton animationActiveToggle;
+
+    int lastProgressWidth = -1;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SettingsView)
+};
@@ -0,0 +1,170 @@
+#include "EnvelopeCapture.h"
+
+//==============================================================================
+class EnvelopeCapture::Writer : public juce::Thread
+{
+public:
+    Writer (EnvelopeCapture& ownerToUse, std::unique_ptr<juce::OutputStream> streamToUse, const juce::File& fileToUse, int64_t startMs)
+        : juce::Thread ("Signalbash Capture"), file (fileToUse), owner (ownerToUse), stream (std::move (streamToUse)), previousMs (startMs)
+    {
+    }
+
+    ~Writer() override
+    {
+        stopThread (5000);
+        drain();
+        stream->flush();
+    }
+
+    void run() override
+    {
+        while (!threadShouldExit()) {
+            drain();
+            wait (drainIntervalMs);
+        }
+    }
+
+    const juce::File file;
+
+private:
+    static constexpr int drainIntervalMs = 100;
+
+    EnvelopeCapture& owner;
+    std::unique_ptr<juce::OutputStream> stream;
+    int64_t previousMs;
+
+    void drain()
+    {
+        auto scope = owner.fifo.read (owner.fifo.getNumReady());
+        scope.forEach ([this] (int index) { write (owner.ring[(size_t) index]); });
+    }
+
+    void write (const Record& record)
+    {
+        stream->writeCompressedInt (static_cast<int> (juce::jlimit<int64_t> (0, std::numeric_limits<int>::max(), record.nowMs - previousMs)));
+        stream->writeCompressedInt (static_cast<int> (record.numSamples));
+        stream->writeCompressedInt (static_cast<int> (record.sampleRate));
+        stream->writeByte (static_cast<char> (record.flags));
+        stream->writeByte (static_cast<char> (record.numChannels));
+        for (int channel = 0; channel < record.numChannels; ++channel) {
+            stream->writeFloat (record.sumOfSquares[channel]);
+        }
+        previousMs = juce::jmax (previousMs, record.nowMs);
+    }
+};
+
+//==============================================================================
+EnvelopeCapture::EnvelopeCapture() = default;
+
+EnvelopeCapture::~EnvelopeCapture()
+{
+    stop();
+}
+
+juce::Result EnvelopeCapture::start (const juce::File& file, const Header& header)
+{
+    if (isCapturing()) {
+        return juce::Result::fail ("Already capturing");
+    }
+
+    file.getParentDirectory().createDirectory();
+    file.deleteFile();
+    auto stream = std::make_unique<juce::FileOutputStream> (file, 1 << 16);
+    if (stream->failedToOpen()) {
+        return juce::Result::fail ("Could not write " + file.getFullPathName());
+    }
+
+    stream->writeInt (static_cast<int> (fileMagic));
+    stream->writeInt (static_cast<int> (fileVersion));
+    stream->writeInt64 (header.startMs);
+    stream->writeDouble (header.thresholdDb);
+    stream->writeInt (header.windowSeconds);
+
+    if (ring.empty()) {
+        ring.resize ((size_t) fifoRecords);
+    }
+    fifo.reset();
+    dropped.store (0, std::memory_order_relaxed);
+
+    writer = std::make_unique<Writer> (*this, std::move (stream), file, header.startMs);
+    writer->startThread (juce::Thread::Priority::background);
+    capturing.store (true, std::memory_order_release);
+
+    DBG("Envelope capture started: " << file.getFullPathName());
+    return juce::Result::ok();
+}
+
+juce::File EnvelopeCapture::stop()
+{
+    if (writer == nullptr) {
+        return {};
+    }
+
+    capturing.store (false, std::memory_order_release);
+    auto file = writer->file;
+    writer = nullptr;
+
+    DBG("Envelope capture stopped, " << getNumDropped() << " blocks dropped");
+    return file;
+}
+
+void EnvelopeCapture::push (const Record& record) noexcept
+{
+    if (!capturing.load (std::memory_order_acquire)) {
+        return;
+    }
+
+    auto scope = fifo.write (1);
+    if (scope.blockSize1 + scope.blockSize2 == 0) {
+        dropped.fetch_add (1, std::memory_order_relaxed);
+        return;
+    }
+
+    scope.forEach ([this, &record] (int index) { ring[(size_t) index] = record; });
+}
+
+juce::File EnvelopeCapture::getDefaultCaptureFile()
+{
+    return juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory)
+        .getChildFile ("Signalbash")
+        .getChildFile ("captures")
+        .getChildFile ("signalbash-envelope-" + juce::Time::getCurrentTime().formatted ("%Y%m%d-%H%M%S") + ".sbenv");
+}
+
+juce::Result EnvelopeCapture::read (juce::InputStream& input, Header& header, std::vector<Record>& records)
+{
+    if (static_cast<uint32_t> (input.readInt()) != fileMagic) {
+        return juce::Result::fail ("Not an envelope capture");
+    }
+    if (static_cast<uint32_t> (input.readInt()) != fileVersion) {
+        return juce::Result::fail ("Unsupported envelope capture version");
+    }
+
+    header.startMs = input.readInt64();
+    header.thresholdDb = input.readDouble();
+    header.windowSeconds = input.readInt();
+    if (header.windowSeconds <= 0) {
+        return juce::Result::fail ("Invalid window length");
+    }
+
+    records.clear();
+    auto nowMs = header.startMs;
+    while (!input.isExhausted()) {
+        Record record;
+        nowMs += input.readCompressedInt();
+        record.nowMs = nowMs;
+        record.numSamples = static_cast<uint32_t> (input.readCompressedInt());
+        record.sampleRate = static_cast<uint32_t> (input.readCompressedInt());
+        record.flags = static_cast<uint8_t> (input.readByte());
+        record.numChannels = static_cast<uint8_t> (input.readByte());
+        if (record.numChannels > maxChannels) {
+            return juce::Result::fail ("Corrupt record " + juce::String ((int) records.size()));
+        }
+        for (int channel = 0; channel < record.numChannels; ++channel) {
+            record.sumOfSquares[channel] = input.readFloat();
+        }
+        records.push_back (record);
+    }
+
+    return juce::Result::ok();
+}
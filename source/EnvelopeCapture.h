@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Opt-in capture of the signal envelope that drives time accounting: one
+    compact record per processed block, with the block size, sample rate,
+    per-channel sum of squares, bypass state, playhead and MIDI flags, written to a
+    binary file that tools/replay feeds back through ActivityAccountant.
+
+    The audio thread only copies a fixed-size record into a lock-free FIFO.
+    A writer thread, which exists only while capturing, encodes the records
+    and appends them to the file. If it falls behind, records are dropped and
+    counted rather than blocking the audio thread.
+
+    File layout (little-endian): a header of magic, version, start time (ms
+    since epoch), detector threshold (dB) and window length (s), then per
+    block the time since the previous block (ms), sample count and sample
+    rate as compressed ints, a flags byte, a channel count byte and one float
+    per channel.
+*/
+class EnvelopeCapture
+{
+public:
+    static constexpr int maxChannels = 8;
+    static constexpr int fifoRecords = 16384;
+
+    enum Flags : uint8_t
+    {
+        bypassed       = 1 << 0,
+        detectedActive = 1 << 1,
+        hasPlayhead    = 1 << 2,
+        playing        = 1 << 3,
+        recording      = 1 << 4,
+        looping        = 1 << 5,
+        midiActive     = 1 << 6    // the MIDI-aware build saw notes or controllers
+    };
+
+    struct Record
+    {
+        int64_t nowMs = 0;
+        uint32_t numSamples = 0;
+        uint32_t sampleRate = 0;
+        uint8_t flags = 0;
+        uint8_t numChannels = 0;
+        float sumOfSquares[maxChannels] = {};
+    };
+
+    struct Header
+    {
+        int64_t startMs = 0;
+        double thresholdDb = 0.0;
+        int windowSeconds = 0;
+    };
+
+    EnvelopeCapture();
+    ~EnvelopeCapture();
+
+    /** Starts writing to file. Call from the message thread. */
+    juce::Result start (const juce::File& file, const Header& header);
+
+    /** Drains what is queued, closes the file and returns it. */
+    juce::File stop();
+
+    bool isCapturing() const noexcept { return capturing.load (std::memory_order_relaxed); }
+
+    /** Queues one block from the audio thread. Never blocks or allocates. */
+    void push (const Record& record) noexcept;
+
+    /** Records lost because the writer fell behind, since start(). */
+    int getNumDropped() const noexcept { return dropped.load (std::memory_order_relaxed); }
+
+    /** A new timestamped file under the user's app data folder. */
+    static juce::File getDefaultCaptureFile();
+
+    /** Reads a whole capture back. */
+    static juce::Result read (juce::InputStream& input, Header& header, std::vector<Record>& records);
+
+    static constexpr uint32_t fileMagic = 0x43454253; // "SBEC"
+    static constexpr uint32_t fileVersion = 1;
+
+private:
+    class Writer;
+
+    // allocated on the first start() and kept, so a late push() never touches freed memory
+    std::vector<Record> ring;
+    juce::AbstractFifo fifo { fifoRecords };
+    std::atomic<bool> capturing { false };
+    std::atomic<int> dropped { 0 };
+    std::unique_ptr<Writer> writer;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (EnvelopeCapture)
+};
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <JuceHeader.h>
+
+#ifndef SIGNALBASH_LOCK_STATS
+ #define SIGNALBASH_LOCK_STATS 0
+#endif
+
+//==============================================================================
+/**
+    A juce::CriticalSection that can count how it is used. Lock it with
+    ScopedLockType, just as you would a juce::ScopedLock.
+
+    With SIGNALBASH_LOCK_STATS=1 it keeps a count of acquisitions, how many of
+    them had to wait for another thread, and the total and maximum time the
+    lock was held. Re-entrant acquisitions are counted once, at the outermost
+    level. With stats disabled it only forwards to the CriticalSection.
+*/
+class InstrumentedCriticalSection
+{
+public:
+    using ScopedLockType = juce::GenericScopedLock<InstrumentedCriticalSection>;
+
+    struct Stats
+    {
+        uint64_t acquisitions = 0;
+        uint64_t contended = 0;
+        double totalHoldMicroseconds = 0.0;
+        double maxHoldMicroseconds = 0.0;
+    };
+
+    void enter() const noexcept
+    {
+       #if SIGNALBASH_LOCK_STATS
+        if (!lock.tryEnter()) {
+            lock.enter();
+            if (depth == 0) contended.fetch_add (1, std::memory_order_relaxed);
+        }
+        if (depth++ == 0) {
+            acquisitions.fetch_add (1, std::memory_order_relaxed);
+            enteredTicks = juce::Time::getHighResolutionTicks();
+        }
+       #else
+        lock.enter();
+       #endif
+    }
+
+    bool tryEnter() const noexcept
+    {
+        if (!lock.tryEnter()) {
+            return false;
+        }
+       #if SIGNALBASH_LOCK_STATS
+        if (depth++ == 0) {
+            acquisitions.fetch_add (1, std::memory_order_relaxed);
+            enteredTicks = juce::Time::getHighResolutionTicks();
+        }
+       #endif
+        return true;
+    }
+
+    void exit() const noexcept
+    {
+       #if SIGNALBASH_LOCK_STATS
+        if (--depth == 0) {
+            auto held = static_cast<uint64_t> (juce::Time::getHighResolutionTicks() - enteredTicks);
+            totalHoldTicks.fetch_add (held, std::memory_order_relaxed);
+            if (held > maxHoldTicks.load (std::memory_order_relaxed)) {
+                maxHoldTicks.store (held, std::memory_order_relaxed);
+            }
+        }
+       #endif
+        lock.exit();
+    }
+
+    Stats getStats() const noexcept
+    {
+        Stats stats;
+       #if SIGNALBASH_LOCK_STATS
+        auto ticksToMicroseconds = 1.0e6 / static_cast<double> (juce::Time::getHighResolutionTicksPerSecond());
+        stats.acquisitions = acquisitions.load (std::memory_order_relaxed);
+        stats.contended = contended.load (std::memory_order_relaxed);
+        stats.totalHoldMicroseconds = static_cast<double> (totalHoldTicks.load (std::memory_order_relaxed)) * ticksToMicroseconds;
+        stats.maxHoldMicroseconds = static_cast<double> (maxHoldTicks.load (std::memory_order_relaxed)) * ticksToMicroseconds;
+       #endif
+        return stats;
+    }
+
+    static constexpr bool statsEnabled = SIGNALBASH_LOCK_STATS != 0;
+
+private:
+    juce::CriticalSection lock;
+
+   #if SIGNALBASH_LOCK_STATS
+    // owned by the thread holding the lock
+    mutable int depth = 0;
+    mutable juce::int64 enteredTicks = 0;
+
+    mutable std::atomic<uint64_t> acquisitions { 0 };
+    mutable std::atomic<uint64_t> contended { 0 };
+    mutable std::atomic<uint64_t> totalHoldTicks { 0 };
+    mutable std::atomic<uint64_t> maxHoldTicks { 0 };
+   #endif
+};
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include "ProcessorState.h"
+
+//==============================================================================
+/**
+    Per-channel input levels handed from the audio thread to the editor
+    through a lock-free triple buffer. The audio thread always owns one slot
+    to write; publishing swaps it with the shared middle slot. The editor
+    swaps the middle slot into its own only when something new was published.
+    Neither side waits, and the editor never sees a half-written snapshot.
+
+    The levels come out of the detector's sum-of-squares pass, so metering
+    adds no pass over the samples. The audio thread only publishes while a
+    meter is on screen (setEnabled).
+*/
+class LevelMeter
+{
+public:
+    static constexpr int maxChannels = 8;
+
+    struct Snapshot
+    {
+        int numChannels = 0;
+        float rms[maxChannels] = {};    // linear
+        float peak[maxChannels] = {};   // linear
+        bool active = false;            // the detector's verdict for the block
+        uint32_t sequence = 0;
+    };
+
+    void setEnabled (bool shouldBeEnabled) noexcept { enabled.store (shouldBeEnabled, std::memory_order_relaxed); }
+    bool isEnabled() const noexcept                 { return enabled.load (std::memory_order_relaxed); }
+
+    /** Audio thread: the slot to fill before publish(). */
+    Snapshot& beginWrite() noexcept { return slots[(size_t) back].snapshot; }
+
+    /** Audio thread: hands the filled slot to the reader. */
+    void publish() noexcept
+    {
+        slots[(size_t) back].snapshot.sequence = ++published;
+        back = middle.exchange (back | dirtyBit, std::memory_order_acq_rel) & indexMask;
+    }
+
+    /** Message thread: copies the newest snapshot, if one arrived since the last read. */
+    bool read (Snapshot& destination) noexcept
+    {
+        if ((middle.load (std::memory_order_relaxed) & dirtyBit) == 0) {
+            return false;
+        }
+
+        front = middle.exchange (front, std::memory_order_acq_rel) & indexMask;
+        destination = slots[(size_t) front].snapshot;
+        return true;
+    }
+
+private:
+    static constexpr int indexMask = 3;
+    static constexpr int dirtyBit = 4;
+
+    // a line of padding ahead of each slot, so the writer's slot never shares one with the reader's
+    struct Slot
+    {
+        CacheLinePadding padding;
+        Snapshot snapshot;
+    };
+
+    std::array<Slot, 3> slots;
+    int back = 0;                   // audio thread
+    uint32_t published = 0;         // audio thread
+    int front = 1;                  // message thread
+    std::atomic<int> middle { 2 };
+    std::atomic<bool> enabled { false };
+};
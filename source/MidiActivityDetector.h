@@ -0,0 +1,111 @@
+#pragma once
+
+#include <bitset>
+#include <cstdint>
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Marks blocks active from the MIDI passing through the plugin, for the
+    MIDI-aware build (JucePlugin_WantsMidiInput). Playing a controller then
+    counts even when the instrument after the plugin is muted or silent.
+
+    A block is active if it carries a note, controller, pitch-bend or
+    aftertouch event, or if a note is still held from an earlier block,
+    because a sustained chord sends nothing until it's released. Clock, transport
+    and other system messages don't count: the host sends those whether
+    anyone is playing or not.
+
+    A note-off can get lost (a controller unplugged mid-note, a host that
+    drops events across a loop or an edit), so held notes only count for
+    heldNoteTimeoutMs after the last event; after that they are forgotten.
+
+    It makes one pass over the buffer's raw bytes and copies nothing. Use it
+    from the audio thread only.
+*/
+class MidiActivityDetector
+{
+public:
+    /** nowMs is the block's wall time, used to expire held notes. */
+    bool process (const juce::MidiBuffer& midi, int64_t nowMs) noexcept
+    {
+        bool sawEvent = false;
+        for (const auto metadata : midi) {
+            if (metadata.numBytes < 2) {
+                continue;
+            }
+
+            const auto* data = metadata.data;
+            const auto channel = data[0] & 0x0f;
+            switch (data[0] & 0xf0) {
+                case 0x90:  // velocity 0 is a note off
+                    if (metadata.numBytes >= 3) {
+                        setHeld (channel, data[1] & 0x7f, data[2] != 0);
+                    }
+                    sawEvent = true;
+                    break;
+                case 0x80:
+                    setHeld (channel, data[1] & 0x7f, false);
+                    sawEvent = true;
+                    break;
+                case 0xb0:
+                    // all sound off, all notes off and the mode changes that imply it
+                    if (data[1] == 120 || data[1] >= 123) {
+                        releaseChannel (channel);
+                    }
+                    sawEvent = true;
+                    break;
+                case 0xa0:
+                case 0xd0:
+                case 0xe0:
+                    sawEvent = true;
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        if (sawEvent) {
+            lastEventMs = nowMs;
+            return true;
+        }
+
+        if (heldNotes > 0 && nowMs - lastEventMs > heldNoteTimeoutMs) {
+            reset();
+        }
+        return heldNotes > 0;
+    }
+
+    /** Forgets held notes, e.g. when the host re-prepares and may have dropped note-offs. */
+    void reset() noexcept
+    {
+        held.reset();
+        heldNotes = 0;
+    }
+
+    /** How long notes count as held with no MIDI at all, long enough for a sustained pad. */
+    static constexpr int64_t heldNoteTimeoutMs = 30 * 1000;
+
+private:
+    static constexpr int notesPerChannel = 128;
+
+    std::bitset<16 * notesPerChannel> held;
+    int heldNotes = 0;
+    int64_t lastEventMs = 0;
+
+    void setHeld (int channel, int note, bool isHeld) noexcept
+    {
+        const auto index = (size_t) (channel * notesPerChannel + note);
+        if (held[index] != isHeld) {
+            held[index] = isHeld;
+            heldNotes += isHeld ? 1 : -1;
+        }
+    }
+
+    void releaseChannel (int channel) noexcept
+    {
+        for (int note = 0; note < notesPerChannel; ++note) {
+            setHeld (channel, note, false);
+        }
+    }
+};
@@ -2,13 +2,14 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "EditorViews.h"
 
 //==============================================================================
 /**
 */
 class SignalbashAudioProcessorEditor  : public juce::AudioProcessorEditor,
                                          private juce::Timer,
-                                         private juce::Button::Listener
+                                         private juce::ChangeListener
 {
 public:
     SignalbashAudioProcessorEditor (SignalbashAudioProcessor&);
@@ -23,44 +24,39 @@ private:
     SignalbashAudioProcessor& audioProcessor;
 
     void timerCallback() override;
-    void buttonClicked (juce::Button* button) override;
+    void changeListenerCallback (juce::ChangeBroadcaster* source) override;
 
-    void mouseDown (const juce::MouseEvent &event) override;
-    void mouseMove (const juce::MouseEvent &event) override;
+    // any pointer activity over the editor or its views wakes a deep-idle processor
+    struct InteractionWaker : public juce::MouseListener
+    {
+        explicit InteractionWaker (SignalbashAudioProcessor& p) : processor (p) {}
 
-    void updateUIForCurrentView();
+        void mouseEnter (const juce::MouseEvent&) override { processor.wakeFromDeepIdle(); }
+        void mouseMove (const juce::MouseEvent&) override  { processor.wakeFromDeepIdle(); }
+        void mouseDown (const juce::MouseEvent&) override  { processor.wakeFromDeepIdle(); }
 
-    bool viewSessionKeyEnter = true;
-    bool viewDefault = false;
-    bool viewSettings = false;
-    bool settingsDebugMode = false;
+        SignalbashAudioProcessor& processor;
+    };
+    InteractionWaker interactionWaker { audioProcessor };
 
-    juce::TextButton flushButton;
+    void mouseDown (const juce::MouseEvent &event) override;
+    void mouseMove (const juce::MouseEvent &event) override;
 
-    juce::TextEditor sessionKeyEditor;
-    juce::Label sessionKeyLabel;
-    juce::TextButton submitSessionKeyButton;
-    juce::TextButton copySessionKeyButton;
-    juce::TextButton changeSessionKeyButton;
-    juce::TextButton editSessionKeyCancelButton;
-    juce::TextButton retrySessionKeyValidateButton;
+    void showView (EditorView::Type type);
 
-    juce::ToggleButton animationActiveToggle;
+    EditorView::Type currentViewType = EditorView::Type::sessionKeyEnter;
+    std::unique_ptr<EditorView> currentView;
+    bool settingsDebugMode = false;
 
     juce::Image settingsCogImage;
     juce::Rectangle<float> settingsCogBounds;
     bool settingsCogHovered = false;
 
-    juce::Image splashLogoImage;
-
-    juce::Image rotatingImage;
-    float rotationAngle = 0.0f;
-    juce::Rectangle<float> spinnerBounds;
-
-    juce::String getObfuscatedSessionKey ();
+    juce::String statusBarMessage;
+    juce::Colour statusBarColour;
+    void updateStatusBar();
 
     juce::Colour bgColor;
-    juce::Colour buttonFillColor;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SignalbashAudioProcessorEditor)
 };
@@ -1,29 +1,23 @@
 #include <string>
+#include <algorithm>
 #include <cmath>
-#include <ctime>
-#include <random>
+#include <vector>
 
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 #include "RestRequest.h"
-
-class BackgroundJob : public juce::ThreadPoolJob
-{
-public:
-    BackgroundJob(std::function<void()> taskToRun)
-        : ThreadPoolJob("BackgroundJob"), task(std::move(taskToRun))
-    {
-    }
-
-    JobStatus runJob() override
-    {
-        task();
-        return jobHasFinished;
-    }
-
-private:
-    std::function<void()> task;
-};
+#include "DeduplicationID.h"
+#include "Tracer.h"
+
+// whether apiBase may come from the settings file: debug builds, and the tools that run
+// processors against a mock (signalbash_add_processor_sources); shipped builds never
+#ifndef SIGNALBASH_API_BASE_OVERRIDE
+ #if JUCE_DEBUG
+  #define SIGNALBASH_API_BASE_OVERRIDE 1
+ #else
+  #define SIGNALBASH_API_BASE_OVERRIDE 0
+ #endif
+#endif
 
 //==============================================================================
 SignalbashAudioProcessor::SignalbashAudioProcessor()
@@ -37,17 +31,20 @@ SignalbashAudioProcessor::SignalbashAudioProcessor()
                      #endif
                        )
 #endif
-, activityWindowTimer(10), submissionWindowTimer(120), threadPool(2)
+, activityWindowTimer(activityDetectionWindow), submissionWindowTimer(submissionAccumulatorWindow),
+  submissionScheduler(submissionAccumulatorWindow)
 {
 
-    activity = 0;
-
-    currentActivityBlock = activityWindowTimer.getCurrentBlockTimestamp();
-    currentSubmissionBlock = submissionWindowTimer.getCurrentBlockTimestamp();
-    currentRecordedActivityMilliseconds = 0;
+    audioState.currentActivityBlock.store(activityWindowTimer.getCurrentBlockTimestamp(), std::memory_order_relaxed);
+    audioState.accountant.reset(audioState.currentActivityBlock.load(std::memory_order_relaxed));
+    seenClockDiscontinuities = activityWindowTimer.getDiscontinuityCount();
 
     deduplicationID = generateDedupID();
+    // no group until the host and session key are known
+    sharedActivityParticipant = sharedActivity->join(0);
 
+    clock->addActiveClient();
+    lastWakeTimestamp = activityWindowTimer.nowMs();
     startTimerHz(2);
 
     bypassParam = new juce::AudioParameterBool({"bypass", 1}, "Bypass", 0);
@@ -68,16 +65,65 @@ SignalbashAudioProcessor::SignalbashAudioProcessor()
     auto filePath = propertiesFile->getFile().getFullPathName();
     DBG("Properties File Path: " << filePath);
 
+    keyValidator->addChangeListener(this);
     loadSessionKeyFromFile();
+    if (propertiesFile != nullptr) {
+        deepIdleAfterSeconds = juce::jmax(30, propertiesFile->getIntValue("deepIdleAfterSeconds", deepIdleAfterSeconds));
+
+        ActivityBacklog::Budget budget;
+        budget.maxEntries = propertiesFile->getIntValue("backlogMaxEntries", budget.maxEntries);
+        budget.maxPayloadBytes = propertiesFile->getIntValue("backlogMaxPayloadBytes", budget.maxPayloadBytes);
+        activityBlocks.setBudget(budget);
+
+       #if SIGNALBASH_API_BASE_OVERRIDE
+        // lets the tools and debug builds point at a mock server
+        apiBase = propertiesFile->getValue("apiBase", apiBase).toStdString();
+       #endif
+    }
+    submissionScheduler.setPhaseMs(loadSubmissionPhaseMs());
 
     parseHost();
-    checkConnectionHealth();
+    updateSharedActivityGroup();
+    keyValidator->configure(apiBase + "/validate-session-key", _PLUGIN_VERSION, uaheader);
+    statsSlot = stats->claim(hostNameDisplay);
+
+    // one process-wide monitor replaces per-instance pings; it only probes once a request has failed
+    controlState.connectionHealthy.store(connection->isHealthy(), std::memory_order_relaxed);
+    connection->addChangeListener(this);
+    connection->setProbeEndpoint(apiBase + "/ping");
+
+    // a cached verdict needs no request; only a key never seen (or long expired) is checked now
+    if (!sessionKey.isEmpty() && keyValidator->getVerdict(sessionKey) == SessionKeyValidator::Verdict::unknown) {
+        validateSessionKey();
+    }
 }
 
 SignalbashAudioProcessor::~SignalbashAudioProcessor()
 {
-    threadPool.removeAllJobs(true, 100);
+    connection->removeChangeListener(this);
+    keyValidator->removeChangeListener(this);
+    keyValidator->setKeyInUse(this, {});
+    cancelPendingUpdate();
+    scheduler->cancelJobs(this, 5000);
     stopTimer();
+    if (!isDeepIdle()) {
+        clock->removeActiveClient();
+    }
+
+    {
+        // hand windows harvested but not yet acknowledged back, so the next leader picks them up;
+        // the segment only holds windows, so buckets are split back into them
+        // (a keyless instance has no group to hand them to, and never submitted them)
+        const InstrumentedCriticalSection::ScopedLockType lock(mutex);
+        const auto group = sharedActivityParticipant.group;
+        for (const auto& [key, span] : activityBlocks) {
+            activityBlocks.forEachWindow(key, span, [this, group](int window, int milliseconds) {
+                sharedActivity->publish(group, window, milliseconds);
+            });
+        }
+    }
+    sharedActivity->leave(sharedActivityParticipant);
+    stats->release(statsSlot);
 
     if (propertiesFile != nullptr)
     {
@@ -94,12 +140,20 @@ const juce::String SignalbashAudioProcessor::getName() const
 
 bool SignalbashAudioProcessor::acceptsMidi() const
 {
+   #if JucePlugin_WantsMidiInput
+    return true;
+   #else
     return false;
+   #endif
 }
 
 bool SignalbashAudioProcessor::producesMidi() const
 {
+   #if JucePlugin_ProducesMidiOutput
+    return true;
+   #else
     return false;
+   #endif
 }
 
 bool SignalbashAudioProcessor::isMidiEffect() const
@@ -139,12 +193,15 @@ void SignalbashAudioProcessor::changeProgramName (int index, const juce::String&
 //==============================================================================
 void SignalbashAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-
+   #if JucePlugin_WantsMidiInput
+    midiActivity.reset();
+   #endif
 }
 
 void SignalbashAudioProcessor::releaseResources()
 {
-
+    // the host stopped or closed the session; don't leave the backlog waiting for the next interval
+    controlState.sessionEndRequested.store(true, std::memory_order_relaxed);
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -170,6 +227,19 @@ bool SignalbashAudioProcessor::isBusesLayoutSupported (const BusesLayout& layout
 
 void SignalbashAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
+    processAudioBlock(buffer, midiMessages);
+}
+
+void SignalbashAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    processAudioBlock(buffer, midiMessages);
+}
+
+template <typename FloatType>
+void SignalbashAudioProcessor::processAudioBlock (juce::AudioBuffer<FloatType>& buffer, juce::MidiBuffer& midiMessages)
+{
+    SIGNALBASH_TRACE_THREAD_NAME("Audio");
+    SIGNALBASH_TRACE_SCOPE("audio", "processBlock");
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
@@ -177,83 +247,142 @@ void SignalbashAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, j
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
 
-    {
-        const juce::ScopedLock lock(mutex);
+    auto numSamples = buffer.getNumSamples();
+    auto nowMilliseconds = activityWindowTimer.nowMs();
+    auto bypassed = bypassParam != nullptr && bypassParam->get();
 
-        if (lastSuccessfullySubmittedBlock != -1) {
+   #if JucePlugin_WantsMidiInput
+    // scanned even when bypassed, so notes held across the bypass stay tracked
+    const auto midiActive = midiActivity.process(midiMessages, nowMilliseconds);
+   #else
+    juce::ignoreUnused(midiMessages);
+    const auto midiActive = false;
+   #endif
 
-            std::vector<int> keysToRemove;
-            for (const auto& [key, value] : activityBlocks) {
-                if (key <= lastSuccessfullySubmittedBlock) {
-                    keysToRemove.push_back(key);
-                }
-            }
-            for (auto key : keysToRemove) {
-                activityBlocks.erase(key);
-                DBG("Removed Activity Key: " << key);
-            }
+    bool hasNonZeroData = false;
+    if (capture.isCapturing() || levelMeter.isEnabled()) {
+        hasNonZeroData = analyseBlock(buffer, totalNumInputChannels, nowMilliseconds, bypassed, midiActive);
+    } else if (!bypassed) {
+        hasNonZeroData = midiActive || activityDetector.isActive(buffer, totalNumInputChannels);
+    }
 
-            lastSuccessfullySubmittedBlock = -1;
+    // the processor lock is only touched when a window closes, never on an ordinary block
+    auto activityBlock = activityWindowTimer.getCurrentBlockTimestamp();
+    const auto group = controlState.sharedActivityGroup.load(std::memory_order_relaxed);
+    auto outcome = audioState.accountant.process({ nowMilliseconds, activityBlock, numSamples, getSampleRate(), hasNonZeroData, isNonRealtime() },
+                                                 [this, group](int64_t fromMs, int64_t toMs) { return sharedActivity->markActive(group, fromMs, toMs); });
+    if (outcome.windowRolled) {
+        SIGNALBASH_TRACE_INSTANT("audio", "activityWindowClose");
+
+        // only time the shared segment could not take is accounted locally
+        if (outcome.closedMilliseconds > 0) {
+            const InstrumentedCriticalSection::ScopedLockType lock(mutex);
+            activityBlocks.add(static_cast<int>(outcome.closedWindow), outcome.closedMilliseconds);
         }
+        audioState.currentActivityBlock.store(activityBlock, std::memory_order_relaxed);
+    }
+    if (outcome.windowRolled || hasNonZeroData) {
+        audioState.currentWindowMilliseconds.store(static_cast<int>(audioState.accountant.getWindowMilliseconds()), std::memory_order_relaxed);
     }
 
-    if (currentActivityBlock != activityWindowTimer.getCurrentBlockTimestamp() && currentRecordedActivityMilliseconds > 0) {
+    // skip redundant stores so readers don't keep pulling the line back
+    if (audioState.signalHot.load(std::memory_order_relaxed) != hasNonZeroData) {
+        audioState.signalHot.store(hasNonZeroData, std::memory_order_relaxed);
+    }
 
-        const juce::ScopedLock lock(mutex);
-        activityBlocks.emplace(currentActivityBlock, currentRecordedActivityMilliseconds);
-        currentActivityBlock = activityWindowTimer.getCurrentBlockTimestamp();
-        currentRecordedActivityMilliseconds = 0;
+    if (hasNonZeroData) {
+        audioState.lastActiveBlockTimestamp.store(nowMilliseconds, std::memory_order_relaxed);
+        // enterDeepIdle() re-reads the timestamp after raising the flag; if both sides miss each
+        // other the next active block sees the flag, and the accounting above never waits on it
+        if (controlState.deepIdle.load(std::memory_order_relaxed)) {
+            triggerAsyncUpdate();
+        }
+        audioState.activity.fetch_add(1, std::memory_order_relaxed);
     }
+}
 
-    if (currentSubmissionBlock != submissionWindowTimer.getCurrentBlockTimestamp()) {
+template <typename FloatType>
+bool SignalbashAudioProcessor::analyseBlock (const juce::AudioBuffer<FloatType>& buffer, int numChannels, int64_t nowMilliseconds, bool bypassed, bool midiActive)
+{
+    // same verdict as ActivityDetector::isActive, but keeping every channel's level for the meter and the capture
+    const auto numSamples = buffer.getNumSamples();
+    const auto capturing = capture.isCapturing();
+    auto* levels = levelMeter.isEnabled() ? &levelMeter.beginWrite() : nullptr;
 
-        commitActivity(false);
+    EnvelopeCapture::Record record;
+    bool active = false;
+    for (int channel = 0; channel < numChannels; ++channel) {
+        double peakSquared = 0.0;
+        auto sum = levels != nullptr ? ActivityDetector::sumOfSquares(buffer.getReadPointer(channel), numSamples, peakSquared)
+                                     : ActivityDetector::sumOfSquares(buffer.getReadPointer(channel), numSamples);
 
-        currentSubmissionBlock = submissionWindowTimer.getCurrentBlockTimestamp();
+        if (levels != nullptr && channel < LevelMeter::maxChannels) {
+            levels->rms[channel] = numSamples > 0 ? static_cast<float>(std::sqrt(sum / numSamples)) : 0.0f;
+            levels->peak[channel] = static_cast<float>(std::sqrt(peakSquared));
+        }
+        if (channel < EnvelopeCapture::maxChannels) {
+            record.sumOfSquares[channel] = static_cast<float>(sum);
+        }
+        active = active || activityDetector.isChannelActive(sum, numSamples);
     }
+    active = active && !bypassed;
 
-    if (bypassParam != nullptr && bypassParam->get()) {
-        signalHot.store(false);
-        lastProcessBlockCallTimestamp = juce::Time::currentTimeMillis();
-        return;
+    if (levels != nullptr) {
+        levels->numChannels = juce::jlimit(0, LevelMeter::maxChannels, numChannels);
+        levels->active = active;
+        levelMeter.publish();
     }
 
-    auto numSamples = buffer.getNumSamples();
-    bool hasNonZeroData = false;
-
-    for (int channel = 0; channel < totalNumInputChannels; ++channel) {
-        auto rmsMagnitude = buffer.getRMSLevel(channel, 0, numSamples);
+    // the meter shows what the audio did; accounting also counts the MIDI
+    if (!capturing) {
+        return active || (midiActive && !bypassed);
+    }
 
-        double db = -196.0;
-        if (rmsMagnitude > 0.0f) {
-            db = 20 * std::log10(rmsMagnitude);
-        }
-        if (db >= minDbThreshold) {
-            hasNonZeroData = true;
-        }
-        if (hasNonZeroData) {
-            break;
+    record.nowMs = nowMilliseconds;
+    record.numSamples = static_cast<uint32_t>(numSamples);
+    record.sampleRate = static_cast<uint32_t>(std::lround(getSampleRate()));
+    record.numChannels = static_cast<uint8_t>(juce::jlimit(0, EnvelopeCapture::maxChannels, numChannels));
+
+    int flags = (bypassed ? EnvelopeCapture::bypassed : 0) | (active ? EnvelopeCapture::detectedActive : 0)
+              | (midiActive ? EnvelopeCapture::midiActive : 0);
+    if (auto* playHead = getPlayHead()) {
+        if (auto position = playHead->getPosition()) {
+            flags |= EnvelopeCapture::hasPlayhead
+                   | (position->getIsPlaying() ? EnvelopeCapture::playing : 0)
+                   | (position->getIsRecording() ? EnvelopeCapture::recording : 0)
+                   | (position->getIsLooping() ? EnvelopeCapture::looping : 0);
         }
     }
+    record.flags = static_cast<uint8_t>(flags);
 
-    if (hasNonZeroData) {
-        signalHot.store(true);
-        ++activity;
-        auto chunkDurationMilliseconds = numSamples / getSampleRate() * 1000;
-        currentRecordedActivityMilliseconds += static_cast<int>(chunkDurationMilliseconds);
-    } else {
-        signalHot.store(false);
+    capture.push(record);
+    return active || (midiActive && !bypassed);
+}
+
+void SignalbashAudioProcessor::toggleEnvelopeCapture ()
+{
+    if (capture.isCapturing()) {
+        auto file = capture.stop();
+        DBG("Envelope capture written to " << file.getFullPathName());
+        file.revealToUser();
+        return;
+    }
+
+    auto result = capture.start(EnvelopeCapture::getDefaultCaptureFile(),
+                                { activityWindowTimer.nowMs(), minDbThreshold, activityDetectionWindow });
+    if (result.failed()) {
+        DBG("Envelope capture failed: " << result.getErrorMessage());
     }
-    lastProcessBlockCallTimestamp = juce::Time::currentTimeMillis();
 }
 
 void SignalbashAudioProcessor::flushAccumulator () {
 
-    for (const auto& [key, value] : activityBlocks) {
-        DBG("Key: " << key << ", Value: " << value);
+    const InstrumentedCriticalSection::ScopedLockType lock(mutex);
+    for (const auto& [key, span] : activityBlocks) {
+        DBG("Key: " << key << ", Value: " << span.milliseconds << " over " << span.seconds << "s");
     }
 
-    commitActivity(true);
+    commitActivity();
 }
 
 void SignalbashAudioProcessor::parseHost () {
@@ -300,31 +429,204 @@ void SignalbashAudioProcessor::parseHost () {
 }
 
 void SignalbashAudioProcessor::timerCallback () {
-    activityWindowTimer.update();
-    submissionWindowTimer.update();
+    SIGNALBASH_TRACE_SCOPE("timer", "timerCallback");
+    auto clockDiscontinuities = activityWindowTimer.getDiscontinuityCount();
+    if (clockDiscontinuities != seenClockDiscontinuities) {
+        // the wall clock stepped (suspend/resume, manual change); don't wait for it to catch up
+        DBG("Clock discontinuity, re-syncing submission schedule");
+        seenClockDiscontinuities = clockDiscontinuities;
+        submissionScheduler.reset();
+    }
 
-    if (activity > 0 && submissionWindowTimer.getCurrentBlockTimestamp() - currentSubmissionBlock > 1) {
+    sharedActivity->heartbeat(sharedActivityParticipant);
+    if (sharedActivity->isLeader(sharedActivityParticipant)) {
+        harvestSharedActivity();
+    }
 
-        DBG("Timer curr block: " << activityWindowTimer.getCurrentBlockTimestamp() << " | Curr registered submission block: " << currentSubmissionBlock);
+    int pendingWindows = 0;
+    int64_t pendingMilliseconds = 0;
+    {
+        const InstrumentedCriticalSection::ScopedLockType lock(mutex);
 
-        if (juce::Time::currentTimeMillis() - lastProcessBlockCallTimestamp > 10000) {
+        // never while a request is in flight: its acknowledgement removes the spans it carried
+        // by key, and a bucket formed meanwhile could hold windows it didn't carry
+        if (!controlState.submissionInFlight.load(std::memory_order_acquire)) {
+            if (auto merged = activityBlocks.compact(activityWindowTimer.nowMs() / 1000); merged > 0) {
+                DBG("Backlog over budget, merged " << static_cast<int>(merged) << " entries into coarser buckets");
+            }
+        }
 
-            DBG("Curr ms: " << juce::Time::currentTimeMillis() << " | lastProcessBlockCallTimestamp: " << lastProcessBlockCallTimestamp);
+        if (audioState.activity.load(std::memory_order_relaxed) > 0) {
+            pendingWindows = static_cast<int>(activityBlocks.size());
+            for (const auto& [key, span] : activityBlocks) {
+                pendingMilliseconds += span.milliseconds;
+            }
+        }
+    }
 
-            DBG("Fallback Activity Submission Triggered");
+    auto now = activityWindowTimer.nowMs();
+    auto lastActive = audioState.lastActiveBlockTimestamp.load(std::memory_order_relaxed);
+    auto reason = submissionScheduler.poll(now, lastActive, pendingWindows,
+                                           controlState.sessionEndRequested.exchange(false, std::memory_order_relaxed));
+
+    if (reason != SubmissionScheduler::Reason::none && !controlState.submissionInFlight.load(std::memory_order_acquire)) {
+        DBG("Submitting " << pendingWindows << " windows (" << (reason == SubmissionScheduler::Reason::interval ? "interval"
+                                                               : reason == SubmissionScheduler::Reason::backlog ? "backlog"
+                                                               : "session end")
+            << "), interval " << submissionScheduler.getIntervalSeconds() << "s");
+        SIGNALBASH_TRACE_INSTANT("timer", "submissionDue");
+        // a call that queued nothing (no key, nothing pending) mustn't push the next interval out
+        if (commitActivity()) {
+            submissionScheduler.submitted(now, pendingMilliseconds);
+        }
+    }
 
-            commitActivity(false);
+    if (audioState.signalHot.load(std::memory_order_relaxed)
+        && activityWindowTimer.getCurrentBlockTimestamp() - audioState.currentActivityBlock.load(std::memory_order_relaxed) > 1) {
+        audioState.signalHot.store(false, std::memory_order_relaxed);
+    }
 
-            currentSubmissionBlock = submissionWindowTimer.getCurrentBlockTimestamp();
-        } else {
-            DBG("Fallback Activity Submission Not activated");
+    auto idleSince = juce::jmax(lastActive, lastWakeTimestamp);
+    if (now - idleSince >= static_cast<int64_t>(deepIdleAfterSeconds) * 1000) {
+        enterDeepIdle(idleSince);
+    } else {
+        publishStats();
+    }
+}
+
+void SignalbashAudioProcessor::publishStats ()
+{
+    if (statsSlot < 0) {
+        return;
+    }
+
+    StatsExport::Stats snapshot;
+    snapshot.updatedMs = activityWindowTimer.nowMs();
+
+    // the audio thread only updates these while the host calls us; a stale window had no activity since
+    auto window = audioState.currentActivityBlock.load(std::memory_order_relaxed);
+    snapshot.currentWindow = activityWindowTimer.getCurrentBlockTimestamp();
+    snapshot.currentWindowMs = window == snapshot.currentWindow ? audioState.currentWindowMilliseconds.load(std::memory_order_relaxed) : 0;
+
+    {
+        const InstrumentedCriticalSection::ScopedLockType lock(mutex);
+        for (const auto& [key, span] : activityBlocks) {
+            ++snapshot.pendingWindows;
+            snapshot.pendingMs += span.milliseconds;
         }
     }
 
-    if (signalHot.load() && activityWindowTimer.getCurrentBlockTimestamp() - currentActivityBlock > 1) {
-        signalHot.store(false);
+    snapshot.flags = (audioState.signalHot.load(std::memory_order_relaxed) ? StatsExport::signalHot : 0u)
+                   | (controlState.connectionHealthy.load(std::memory_order_relaxed) ? StatsExport::connectionHealthy : 0u)
+                   | (controlState.sessionKeyValidated.load(std::memory_order_relaxed) ? StatsExport::sessionKeyValidated : 0u)
+                   | (isDeepIdle() ? StatsExport::deepIdle : 0u)
+                   | (sharedActivity->isLeader(sharedActivityParticipant) ? StatsExport::leader : 0u);
+
+    stats->publish(statsSlot, snapshot);
+}
+
+void SignalbashAudioProcessor::enterDeepIdle (int64_t idleSince)
+{
+    DBG("Entering deep idle");
+    SIGNALBASH_TRACE_INSTANT("timer", "enterDeepIdle");
+
+    // flush whatever is pending once; commitActivity is a no-op without a backlog
+    if (!controlState.submissionInFlight.load(std::memory_order_acquire)) {
+        commitActivity();
+    }
+
+    stopTimer();
+    audioState.signalHot.store(false, std::memory_order_relaxed);
+    controlState.deepIdle.store(true, std::memory_order_release);
+    clock->removeActiveClient();
+    idleStateBroadcaster.sendChangeMessage();
+    publishStats();
+
+    // an active block that landed before deepIdle was set won't have triggered a wake
+    if (audioState.lastActiveBlockTimestamp.load(std::memory_order_relaxed) > idleSince) {
+        wakeFromDeepIdle();
+    }
+}
+
+void SignalbashAudioProcessor::wakeFromDeepIdle ()
+{
+    if (!isDeepIdle() || !controlState.deepIdle.exchange(false, std::memory_order_acq_rel)) {
+        return;
+    }
+
+    DBG("Leaving deep idle");
+    SIGNALBASH_TRACE_INSTANT("timer", "leaveDeepIdle");
+
+    clock->addActiveClient();
+    lastWakeTimestamp = activityWindowTimer.nowMs();
+    sharedActivity->heartbeat(sharedActivityParticipant);
+    startTimerHz(2);
+    idleStateBroadcaster.sendChangeMessage();
+}
+
+void SignalbashAudioProcessor::handleAsyncUpdate ()
+{
+    wakeFromDeepIdle();
+}
+
+void SignalbashAudioProcessor::changeListenerCallback (juce::ChangeBroadcaster* source)
+{
+    if (source == connection.get()) {
+        connectionStateChanged();
+    } else if (source == keyValidator.get()) {
+        applySessionKeyVerdict();
+    }
+}
+
+void SignalbashAudioProcessor::connectionStateChanged ()
+{
+    auto healthy = connection->isHealthy();
+    auto wasHealthy = controlState.connectionHealthy.exchange(healthy, std::memory_order_relaxed);
+    if (!healthy || wasHealthy) {
+        return;
+    }
+
+    // back online: send what piled up while offline instead of waiting for the schedule
+    DBG("Connection restored, flushing backlog");
+    if (!controlState.submissionInFlight.load(std::memory_order_acquire)) {
+        commitActivity();
+    }
+    if (!sessionKey.isEmpty() && !isCurrentSessionKeyValidated()) {
+        validateSessionKey();
+    }
+}
+
+void SignalbashAudioProcessor::harvestSharedActivity ()
+{
+    // leave the most recently closed window for late publishers
+    auto cutoff = activityWindowTimer.getCurrentBlockTimestamp() - activityDetectionWindow;
+
+    // collected outside the lock, which the audio thread takes at every window close
+    std::vector<std::pair<int64_t, int>> windows;
+    sharedActivity->harvest(sharedActivityParticipant.group, cutoff, [&windows](int64_t window, int milliseconds) {
+        windows.emplace_back(window, milliseconds);
+    });
+
+    const auto harvested = static_cast<int>(windows.size());
+    if (harvested > 0) {
+        {
+            const InstrumentedCriticalSection::ScopedLockType lock(mutex);
+            for (const auto& [window, milliseconds] : windows) {
+                activityBlocks.merge(static_cast<int>(window), milliseconds);
+            }
+        }
+
+        DBG("Harvested " << harvested << " shared activity windows");
+        audioState.activity.fetch_add(harvested, std::memory_order_relaxed);
     }
+}
 
+void SignalbashAudioProcessor::updateSharedActivityGroup ()
+{
+    // the leader submits the union under its own key, so only instances on the same host and key merge
+    auto group = SharedActivitySegment::groupFor(hostName, sessionKey);
+    sharedActivity->setGroup(sharedActivityParticipant, group);
+    controlState.sharedActivityGroup.store(group, std::memory_order_relaxed);
 }
 
 //==============================================================================
@@ -356,75 +658,59 @@ juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
     return new SignalbashAudioProcessor();
 }
 
-void SignalbashAudioProcessor::checkConnectionHealth ()
+static void recordAcknowledgedActivity (ActivityHistoryStore& history, const juce::var& activityVals,
+                                        const juce::String& host, const juce::String& instanceID)
 {
-    auto targetEndpoint = apiBase + "/ping";
+    auto* windows = activityVals.getDynamicObject();
+    if (windows == nullptr) return;
 
-    auto weakThis = juce::WeakReference<SignalbashAudioProcessor>(this);
-    std::function<void()> requestTask = [weakThis, targetEndpoint]()
-    {
-        if (weakThis == nullptr) return;
+    std::vector<ActivityHistoryStore::Record> records;
+    records.reserve(static_cast<size_t>(windows->getProperties().size()));
 
-        int maxAttempts = 5;
-        int currAttempt = 1;
-        while (currAttempt <= maxAttempts) {
-            if (weakThis == nullptr) break;
+    auto hostHash = ActivityHistoryStore::hashOf(host);
+    auto instanceHash = ActivityHistoryStore::hashOf(instanceID);
+    for (const auto& window : windows->getProperties()) {
+        records.push_back({ window.name.toString().getLargeIntValue(), static_cast<int32_t>(static_cast<int>(window.value)),
+                            hostHash, instanceHash });
+    }
+    std::sort(records.begin(), records.end(), [](const auto& a, const auto& b) { return a.timestamp < b.timestamp; });
 
-            RestRequest request;
-            request.header("Content-Type", "application/json");
-            RestRequest::Response response = request.get(targetEndpoint).execute();
+    history.append(records);
+}
 
-            if (response.status == 200) {
-                if (auto* proc = weakThis.get()) {
-                    DBG("/ping => Connection Healthy");
-                    proc->connectionHealthy.store(true);
-                }
-                break;
-            }
-            else if (response.result.getErrorMessage() == "No internet connection") {
-                if (auto* proc = weakThis.get()) {
-                    proc->connectionHealthy.store(false);
-                    DBG("No internet detected.");
-                }
-            }
-            else if (response.result.getErrorMessage() == "Server is offline or unreachable") {
-                if (auto* proc = weakThis.get()) {
-                    proc->connectionHealthy.store(false);
-                    DBG("Server is temporarily offline or unreachable");
-                }
-            }
+bool SignalbashAudioProcessor::commitActivity ()
+{
+    ActivityBacklog::Spans activityBlocksCopy;
+    juce::String currentSessionKey;
+    int submittedActivity = 0;
+    {
+        const InstrumentedCriticalSection::ScopedLockType lock(mutex);
+        currentSessionKey = sessionKey;
 
-            if (weakThis == nullptr) break;
-            juce::Thread::sleep(currAttempt * currAttempt * 1000);
-            currAttempt += 1;
+        if (currentSessionKey.isEmpty()) {
+            DBG("Session key is not set, cannot submit activity");
+            return false;
         }
-    };
-    threadPool.addJob(new BackgroundJob(requestTask), true);
-}
 
-void SignalbashAudioProcessor::commitActivity (bool immediateSubmit)
-{
-    if (sessionKey.isEmpty()) {
-        DBG("Session key is not set, cannot submit activity");
-        return;
-    }
+        submittedActivity = audioState.activity.load(std::memory_order_relaxed);
+        if (activityBlocks.empty() || submittedActivity == 0) {
+            DBG("No Pending Activity to commit.");
+            return false;
+        }
 
-    if (activityBlocks.empty() || activity == 0) {
-        DBG("No Pending Activity to commit.");
-        return;
+        activityBlocksCopy = activityBlocks.getSpans();
     }
 
-    std::unordered_map<int, int> activityBlocksCopy;
-    int mostRecentBlock = -1;
-    {
-        const juce::ScopedLock lock(mutex);
-        activityBlocksCopy = activityBlocks;
+    // one submission in flight per instance; the scheduler picks the backlog up again once it settles
+    if (controlState.submissionInFlight.exchange(true, std::memory_order_acq_rel)) {
+        DBG("Submission already in flight.");
+        return false;
     }
 
     juce::StringPairArray parameters;
 
     parameters.set("host", hostName);
-    parameters.set("session_key", sessionKey);
+    parameters.set("session_key", currentSessionKey);
     parameters.set("version", _PLUGIN_VERSION);
     parameters.set("deduplication_id", deduplicationID);
     parameters.set("ua", uaheader);
@@ -432,33 +718,50 @@ void SignalbashAudioProcessor::commitActivity (bool immediateSubmit)
     DBG(parameters.getDescription());
 
     auto* activityDictObj = new juce::DynamicObject();
-    for (const auto& [key, value] : activityBlocksCopy) {
-
-        if (key > mostRecentBlock) {
-            mostRecentBlock = key;
+    auto* idempotencyKeysObj = new juce::DynamicObject();
+    juce::DynamicObject::Ptr activitySpansObj;
+    DeduplicationID::BatchKey batchKey;
+    for (const auto& [key, span] : activityBlocksCopy) {
+        activityDictObj->setProperty(juce::String(key), juce::var(span.milliseconds));
+
+        // a merged bucket is sent under its start with its length alongside, and keyed apart from a window
+        // there; time that arrived after part of a span was acknowledged is keyed apart from that part
+        auto isWindow = activityBlocks.isWindow(span);
+        auto keyOwner = span.part > 0 ? deduplicationID + "#" + std::to_string(span.part) : deduplicationID;
+        auto windowKey = isWindow ? DeduplicationID::idempotencyKey(keyOwner, key)
+                                  : DeduplicationID::idempotencyKey(keyOwner, key, span.seconds);
+        batchKey.add(windowKey);
+        idempotencyKeysObj->setProperty(juce::String(key), juce::var(juce::String(windowKey)));
+
+        if (!isWindow) {
+            if (activitySpansObj == nullptr) {
+                activitySpansObj = new juce::DynamicObject();
+            }
+            activitySpansObj->setProperty(juce::String(key), juce::var(span.seconds));
         }
-        activityDictObj->setProperty(juce::String(key), juce::var(value));
     }
     juce::var activityVals = juce::var(activityDictObj);
+    juce::var idempotencyKeys = juce::var(idempotencyKeysObj);
+    juce::var activitySpans = activitySpansObj != nullptr ? juce::var(activitySpansObj.get()) : juce::var();
+    parameters.set("idempotency_key", batchKey.toString());
 
     auto endpoint = apiBase + "/submit";
 
     auto weakThis = juce::WeakReference<SignalbashAudioProcessor>(this);
+    auto limiter = rateLimiter;
+    auto monitor = connection;
+    auto history = historyStore;
 
-    std::function<void()> requestTask = [weakThis, parameters, activityVals, mostRecentBlock, endpoint, immediateSubmit]()
+    std::function<void()> requestTask = [weakThis, limiter, monitor, history, parameters, activityVals, idempotencyKeys, activitySpans,
+                                         submitted = std::move(activityBlocksCopy), submittedActivity, endpoint]()
     {
-        if (weakThis == nullptr) return;
-
-        if (!immediateSubmit) {
-
-            std::random_device rd;
-            std::mt19937 gen(rd());
-            std::uniform_int_distribution<> distr(0, 10000);
+        const juce::ScopeGuard clearInFlight { [weakThis] {
+            if (auto* proc = weakThis.get()) {
+                proc->controlState.submissionInFlight.store(false, std::memory_order_release);
+            }
+        } };
 
-            int randomSleepTime = distr(gen);
-            juce::Thread::sleep(randomSleepTime);
-            if (weakThis == nullptr) return;
-        }
+        if (weakThis == nullptr) return;
 
         int maxAttempts = 5;
         int currAttempt = 1;
@@ -467,70 +770,73 @@ void SignalbashAudioProcessor::commitActivity (bool immediateSubmit)
             if (weakThis == nullptr) break;
 
             if (auto* proc = weakThis.get()) {
-                if (proc->activity == 0) {
+                if (proc->audioState.activity.load(std::memory_order_relaxed) == 0) {
                     return;
                 }
             }
 
+            if (!limiter->acquire([weakThis] { return weakThis == nullptr || BackgroundScheduler::currentJobShouldExit(); })) break;
+
             RestRequest request;
             request.header("Content-Type", "application/json");
+            request.header("Idempotency-Key", parameters["idempotency_key"]);
             #if JUCE_WINDOWS
             request.header("User-Agent", parameters["ua"]);
             #endif
-            RestRequest::Response response = request.post(endpoint)
+            request.post(endpoint)
                 .field("host", parameters["host"])
                 .field("plugin_version", parameters["version"])
                 .field("session_key", parameters["session_key"])
                 .field("dd_id", parameters["deduplication_id"])
                 .field("activity", activityVals)
+                .field("idempotency_keys", idempotencyKeys);
+            if (activitySpans.isObject()) {
+                request.field("activity_spans", activitySpans);
+            }
+            RestRequest::Response response = request.expect(RestRequest::ResponseMode::statusOnly)
                 .execute();
+            limiter->recordResponse(response.status, response.headers);
+            monitor->reportResponse(response.status);
 
             if (response.status == 200) {
                 if (auto* proc = weakThis.get()) {
                     DBG("Activity Data Submitted! Resetting");
-                    const juce::ScopedLock lock(proc->mutex);
-                    proc->lastSuccessfullySubmittedBlock = mostRecentBlock;
-                    proc->activity.exchange(0);
-                    proc->connectionHealthy.store(true);
+                    const InstrumentedCriticalSection::ScopedLockType lock(proc->mutex);
+                    // exactly what this request carried; anything merged in since stays pending
+                    proc->activityBlocks.acknowledge(submitted);
+                    // keep activity recorded while this request was in flight pending
+                    auto& activity = proc->audioState.activity;
+                    auto pending = activity.load(std::memory_order_relaxed);
+                    while (!activity.compare_exchange_weak(pending, juce::jmax(0, pending - submittedActivity), std::memory_order_relaxed)) {}
                 }
+                recordAcknowledgedActivity(*history, activityVals, parameters["host"], parameters["deduplication_id"]);
                 return;
             }
-            else if (response.status == 429) {
-                if (auto* proc = weakThis.get()) {
-                    DBG("429 - Rate Limited. Will retry next pass.");
-                    proc->connectionHealthy.store(true);
-                }
-                if (weakThis == nullptr) break;
-                juce::Thread::sleep(currAttempt * currAttempt * 1000);
+            else if (RateLimiter::pausesPipeline(response.status)) {
+                DBG(response.status << " - Rate Limited or Unavailable. Pipeline paused, retrying once the limiter allows.");
+                // the limiter has paused every request type, the next acquire() waits it out
                 currAttempt += 1;
             }
             else if (response.status == 0) {
-                if (auto* proc = weakThis.get()) {
-                    DBG("Internet connection down or Server Offline");
-                    proc->connectionHealthy.store(false);
-                }
-                if (weakThis == nullptr) break;
-                juce::Thread::sleep(currAttempt * currAttempt * 1000);
-                currAttempt += 1;
+                // no point retrying blind: the monitor probes and every instance flushes on reconnect
+                DBG("Internet connection down or Server Offline. Waiting for the connection to return.");
+                return;
             }
             else {
-                DBG(response.bodyAsString);
                 DBG(response.result.getErrorMessage());
                 DBG("Status Code: " << response.status);
                 DBG("Generic Request Error. Sleeping, then retrying");
                 if (weakThis == nullptr) break;
-                juce::Thread::sleep(currAttempt * currAttempt * 1000);
+                if (!BackgroundScheduler::sleep(limiter->getBackoffMs(currAttempt))) break;
                 currAttempt += 1;
             }
         }
 
-        if (auto* proc = weakThis.get()) {
-            proc->checkConnectionHealth();
-        }
         DBG("Request Attempt Exhaustion.");
     };
 
-    threadPool.addJob(new BackgroundJob(requestTask), true);
+    scheduler->submit(this, "submit", std::move(requestTask));
+    return true;
 }
 
 void SignalbashAudioProcessor::validateSessionKey ()
@@ -540,67 +846,15 @@ void SignalbashAudioProcessor::validateSessionKey ()
         return;
     }
 
-    if (sessionKeyValidated.load()) {
-        DBG("Session Key Validated. Nothing to do.");
-        return;
-    }
-
-    juce::StringPairArray parameters;
-    parameters.set("session_key", sessionKey);
-    parameters.set("version", _PLUGIN_VERSION);
-    parameters.set("ua", uaheader);
-
-    auto targetEndpoint = apiBase + "/validate-session-key";
-
-    auto weakThis = juce::WeakReference<SignalbashAudioProcessor>(this);
-    std::function<void()> requestTask = [weakThis, parameters, targetEndpoint]()
-    {
-        if (weakThis == nullptr) return;
-
-        RestRequest request;
-        request.header("Content-Type", "application/json");
-        #if JUCE_WINDOWS
-        request.header("User-Agent", parameters["ua"]);
-        #endif
-        RestRequest::Response response = request.post(targetEndpoint)
-            .field("plugin_version", parameters["version"])
-            .field("session_key", parameters["session_key"])
-            .execute();
+    // single-flight across every instance; a fresh cached verdict means no request at all
+    keyValidator->validate(sessionKey);
+}
 
-        if (response.status == 200)
-        {
-            if (auto* proc = weakThis.get()) {
-                DBG("Session Key Validated!");
-                proc->currentSessionKeyInvalid.store(false);
-                proc->sessionKeyValidated.store(true);
-                proc->saveValidSessionKeyState();
-                proc->connectionHealthy.store(true);
-            }
-        }
-        else if (response.status == 404) {
-            if (auto* proc = weakThis.get()) {
-                DBG("Unknown Session Key");
-                proc->currentSessionKeyInvalid.store(true);
-                proc->sessionKeyValidated.store(false);
-                proc->connectionHealthy.store(true);
-            }
-        }
-        else if (response.status == 429)
-        {
-            if (auto* proc = weakThis.get()) {
-                DBG("429 - Rate Limited. Will retry next pass.");
-                proc->connectionHealthy.store(true);
-            }
-        }
-        else if (response.status == 0) {
-            if (auto* proc = weakThis.get()) {
-                DBG("No Internet or Server Offline");
-                proc->connectionHealthy.store(false);
-                proc->checkConnectionHealth();
-            }
-        }
-    };
-    threadPool.addJob(new BackgroundJob(requestTask), true);
+void SignalbashAudioProcessor::applySessionKeyVerdict ()
+{
+    auto verdict = sessionKey.isEmpty() ? SessionKeyValidator::Verdict::unknown : keyValidator->getVerdict(sessionKey);
+    controlState.sessionKeyValidated.store(verdict == SessionKeyValidator::Verdict::valid, std::memory_order_relaxed);
+    controlState.currentSessionKeyInvalid.store(verdict == SessionKeyValidator::Verdict::invalid, std::memory_order_relaxed);
 }
 
 void SignalbashAudioProcessor::loadSessionKeyFromFile()
@@ -609,18 +863,25 @@ void SignalbashAudioProcessor::loadSessionKeyFromFile()
         sessionKey = propertiesFile->getValue("sessionKey", "");
         DBG("Loaded Session Key From File: " << sessionKey);
 
-        enableAnimation.store(propertiesFile->getBoolValue("animationEnabled", true));
-        if (enableAnimation.load()) {
+        controlState.enableAnimation.store(propertiesFile->getBoolValue("animationEnabled", true), std::memory_order_relaxed);
+        if (controlState.enableAnimation.load(std::memory_order_relaxed)) {
             DBG("Loaded Pref => Animation Enabled: ON");
         } else {
             DBG("Loaded Pref => Animation Enabled: OFF");
         }
 
         if (!sessionKey.isEmpty()) {
-            auto sessionKeyValidatedKey = sessionKey.toUpperCase() + "_validity";
-            sessionKeyValidated.store(propertiesFile->getBoolValue(sessionKeyValidatedKey));
+            // verdicts now live in the shared cache, with an expiry; carry the old flag over once
+            auto legacyValidityKey = sessionKey.toUpperCase() + "_validity";
+            if (propertiesFile->containsKey(legacyValidityKey)) {
+                keyValidator->importLegacyVerdict(sessionKey, propertiesFile->getBoolValue(legacyValidityKey));
+                propertiesFile->removeValue(legacyValidityKey);
+            }
         }
     }
+
+    keyValidator->setKeyInUse(this, sessionKey);
+    applySessionKeyVerdict();
 }
 
 void SignalbashAudioProcessor::saveSessionKeyToFile()
@@ -631,27 +892,21 @@ void SignalbashAudioProcessor::saveSessionKeyToFile()
     }
 }
 
-void SignalbashAudioProcessor::saveValidSessionKeyState()
-{
-    if (propertiesFile != nullptr) {
-        auto sessionKeyValidatedKey = sessionKey.toUpperCase() + "_validity";
-        propertiesFile->setValue(sessionKeyValidatedKey, true);
-        propertiesFile->saveIfNeeded();
-    }
-}
-
 void SignalbashAudioProcessor::setSessionKey(const juce::String& newSessionKey)
 {
-    sessionKey = newSessionKey;
+    {
+        // commitActivity snapshots the key under the lock, from the timer or any thread calling flushAccumulator
+        const InstrumentedCriticalSection::ScopedLockType lock(mutex);
+        sessionKey = newSessionKey;
+    }
     saveSessionKeyToFile();
+    updateSharedActivityGroup();
 
-    auto sessionKeyValidatedKey = sessionKey.toUpperCase() + "_validity";
-    if (propertiesFile != nullptr && !propertiesFile->getBoolValue(sessionKeyValidatedKey)) {
-        sessionKeyValidated.store(false);
-        validateSessionKey();
-    } else {
-        currentSessionKeyInvalid.store(false);
-        sessionKeyValidated.store(true);
+    keyValidator->setKeyInUse(this, sessionKey);
+    applySessionKeyVerdict();
+    if (!sessionKey.isEmpty() && !controlState.sessionKeyValidated.load(std::memory_order_relaxed)) {
+        // entered by hand: ask again even if the cache says it was invalid a moment ago
+        keyValidator->validate(sessionKey, true);
     }
 }
 
@@ -661,32 +916,47 @@ bool SignalbashAudioProcessor::isCurrentSessionKeyValidated ()
         return false;
     }
 
-    if (currentSessionKeyInvalid.load()) {
+    if (controlState.currentSessionKeyInvalid.load(std::memory_order_relaxed)) {
         return true;
     }
 
-    return sessionKeyValidated.load();
+    return controlState.sessionKeyValidated.load(std::memory_order_relaxed);
 }
 
 void SignalbashAudioProcessor::toggleAnimationEnabled (bool state)
 {
-    enableAnimation.store(state);
+    controlState.enableAnimation.store(state, std::memory_order_relaxed);
     if (propertiesFile != nullptr) {
         propertiesFile->setValue("animationEnabled", state);
         propertiesFile->saveIfNeeded();
     }
 }
 
-std::string SignalbashAudioProcessor::generateDedupID()
+int64_t SignalbashAudioProcessor::loadSubmissionPhaseMs()
 {
-    static unsigned int seed = static_cast<unsigned int>(std::time(nullptr));
-    std::string result;
-    result.reserve(8);
+    // fixed per install, so the fleet spreads evenly across each submission interval
+    const juce::String phaseKey = "submissionPhaseMs";
+    auto intervalMs = static_cast<int64_t>(submissionAccumulatorWindow) * 1000;
 
-    for (int i = 0; i < 8; ++i) {
-        seed = (1103515245 * seed + 12345);
-        char digit = '0' + (seed % 10);
-        result += digit;
+    if (propertiesFile != nullptr && propertiesFile->containsKey(phaseKey)) {
+        return propertiesFile->getValue(phaseKey).getLargeIntValue();
+    }
+
+    auto phaseMs = juce::Random::getSystemRandom().nextInt64();
+    phaseMs = ((phaseMs % intervalMs) + intervalMs) % intervalMs;
+    if (propertiesFile != nullptr) {
+        propertiesFile->setValue(phaseKey, juce::String(phaseMs));
+        propertiesFile->saveIfNeeded();
     }
-    return result;
+    return phaseMs;
+}
+
+double SignalbashAudioProcessor::getSubmissionProgress() const
+{
+    return submissionScheduler.getProgress(activityWindowTimer.nowMs());
+}
+
+std::string SignalbashAudioProcessor::generateDedupID()
+{
+    return DeduplicationID::generate();
 }
@@ -1,16 +1,32 @@
 #pragma once
 
 #include <cstdint>
-#include <unordered_map>
 #include <atomic>
 #include <memory>
 #include <JuceHeader.h>
+#include "ActivityBacklog.h"
+#include "ActivityDetector.h"
+#include "ActivityHistoryStore.h"
+#include "BackgroundScheduler.h"
+#include "ClockService.h"
+#include "ConnectionMonitor.h"
 #include "CurrentElapsedTimeProgress.h"
+#include "EnvelopeCapture.h"
+#include "InstrumentedCriticalSection.h"
+#include "LevelMeter.h"
+#include "MidiActivityDetector.h"
+#include "ProcessorState.h"
+#include "RateLimiter.h"
+#include "SessionKeyValidator.h"
+#include "SharedActivitySegment.h"
+#include "StatsExport.h"
+#include "SubmissionScheduler.h"
 
 //==============================================================================
 /**
 */
-class SignalbashAudioProcessor  : public juce::AudioProcessor, public juce::Timer
+class SignalbashAudioProcessor  : public juce::AudioProcessor, public juce::Timer, private juce::AsyncUpdater,
+                                  private juce::ChangeListener
 {
 public:
     //==============================================================================
@@ -26,6 +42,8 @@ public:
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override { return true; }
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -50,25 +68,49 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
 
-    std::atomic<int> activity;
+    // one cache-line block per writing thread, see ProcessorState.h
+    AudioThreadState audioState;
+    ControlState controlState;
+
     void flushAccumulator ();
 
+    // debug: records the per-block envelope for tools/replay
+    EnvelopeCapture capture;
+    void toggleEnvelopeCapture ();
+
+    // per-channel levels for the editor's meter, published only while it is shown
+    LevelMeter levelMeter;
+
     const double minDbThreshold = -60.0;
+    const ActivityDetector activityDetector { minDbThreshold };
+
+   #if JucePlugin_WantsMidiInput
+    // audio thread only
+    MidiActivityDetector midiActivity;
+   #endif
 
     const int activityDetectionWindow = 10;
     const int submissionAccumulatorWindow = 2 * 60;
 
     CurrentElapsedTimeProgress activityWindowTimer;
     CurrentElapsedTimeProgress submissionWindowTimer;
-
-    int64_t currentActivityBlock;
-    int64_t currentSubmissionBlock;
-
-    std::atomic<bool> signalHot{false};
-
-    int currentRecordedActivityMilliseconds;
-
-    std::unordered_map<int, int> activityBlocks;
+    uint32_t seenClockDiscontinuities = 0;
+
+    // message thread only
+    SubmissionScheduler submissionScheduler;
+    int64_t loadSubmissionPhaseMs();
+    double getSubmissionProgress() const;
+
+    // deep idle: after deepIdleAfterSeconds without an active block, pending windows are
+    // flushed once and the timer, clock tick and (once drained) worker threads park until
+    // an active block or the editor wakes them; listeners hear about both transitions
+    int deepIdleAfterSeconds = 300;
+    int64_t lastWakeTimestamp = 0;
+    juce::ChangeBroadcaster idleStateBroadcaster;
+    bool isDeepIdle() const { return controlState.deepIdle.load(std::memory_order_acquire); }
+    void enterDeepIdle (int64_t idleSince);
+    void wakeFromDeepIdle ();
+    juce::SharedResourcePointer<ClockService> clock;
 
     void timerCallback() override;
 
@@ -84,29 +126,45 @@ public:
     #else
     std::string apiBase = "https://api.signalbash.com";
     #endif
-    void commitActivity (bool immediateSubmit);
-    int lastSuccessfullySubmittedBlock = -1;
-    int64_t lastProcessBlockCallTimestamp = -1;
+    /** Queues a submission of the backlog. False if nothing was queued (no key, nothing pending, or one in flight). */
+    bool commitActivity ();
 
     juce::String uaheader = "JUCE_PLUGIN";
 
     std::string generateDedupID();
     std::string deduplicationID;
 
-    std::atomic<bool> connectionHealthy{true};
-    void checkConnectionHealth();
+    // connectionHealthy mirrors the process-wide monitor; a reconnect flushes the backlog
+    juce::SharedResourcePointer<ConnectionMonitor> connection;
+    void connectionStateChanged();
+
+    // sessionKeyValidated / currentSessionKeyInvalid mirror the process-wide verdict cache
+    juce::SharedResourcePointer<SessionKeyValidator> keyValidator;
+
+    // guards activityBlocks, which shares its line; padded rather than aligned, see CacheLinePadding
+    CacheLinePadding mutexPadding;
+    InstrumentedCriticalSection mutex;
+    ActivityBacklog activityBlocks { activityDetectionWindow };
+
+    juce::SharedResourcePointer<BackgroundScheduler> scheduler;
+    juce::SharedResourcePointer<RateLimiter> rateLimiter;
+    juce::SharedResourcePointer<ActivityHistoryStore> historyStore;
 
-    juce::CriticalSection mutex;
-    juce::ThreadPool threadPool;
+    juce::SharedResourcePointer<SharedActivitySegment> sharedActivity;
+    SharedActivitySegment::Participant sharedActivityParticipant;
+    void harvestSharedActivity();
+    void updateSharedActivityGroup();
+
+    // live state for local dashboards, published from the timer (see StatsExport)
+    juce::SharedResourcePointer<StatsExport> stats;
+    int statsSlot = -1;
+    void publishStats ();
 
     juce::String sessionKey;
-    std::atomic<bool> enableAnimation{true};
     std::unique_ptr<juce::PropertiesFile> propertiesFile;
 
-    std::atomic<bool> sessionKeyValidated{false};
-    std::atomic<bool> currentSessionKeyInvalid{false};
     void validateSessionKey();
-    void saveValidSessionKeyState();
+    void applySessionKeyVerdict();
     bool isCurrentSessionKeyValidated ();
 
     juce::String getSessionKey() const { return sessionKey; }
@@ -120,6 +178,14 @@ public:
     juce::AudioProcessorParameter *getBypassParameter() const override { return bypassParam; }
 
 private:
+    void handleAsyncUpdate() override;
+    void changeListenerCallback (juce::ChangeBroadcaster* source) override;
+
+    template <typename FloatType>
+    void processAudioBlock (juce::AudioBuffer<FloatType>&, juce::MidiBuffer&);
+    template <typename FloatType>
+    bool analyseBlock (const juce::AudioBuffer<FloatType>&, int numChannels, int64_t nowMilliseconds, bool bypassed, bool midiActive);
+
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SignalbashAudioProcessor)
     JUCE_DECLARE_WEAK_REFERENCEABLE(SignalbashAudioProcessor)
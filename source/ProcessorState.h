@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "ActivityAccountant.h"
+
+//==============================================================================
+/**
+    The processor's cross-thread state, split by the thread that writes it.
+
+    Every block is padded by a full cache line on either side, so the audio
+    thread's per-block stores never invalidate a line the message thread or the
+    workers are writing, and vice versa. Only true sharing is left: a reader of another
+    thread's block pulls that line in, but the writer's next store no longer
+    has to win it back from an unrelated write.
+
+    None of these fields publishes other data, so they are accessed with
+    relaxed ordering unless a comment at the use says otherwise; anything that
+    has to be consistent with the activity map goes through the processor lock.
+*/
+#if defined (__APPLE__) && defined (__aarch64__)
+ inline constexpr std::size_t cacheLineSize = 128;
+#else
+ inline constexpr std::size_t cacheLineSize = 64;
+#endif
+
+/** A cache line of padding. Padding rather than alignas keeps the processor at
+    default alignment: an over-aligned type needs aligned operator new, which
+    the x86_64 macOS slice doesn't get below a 10.13 deployment target.
+*/
+struct CacheLinePadding
+{
+    char bytes[cacheLineSize];
+};
+
+/** Written by the audio thread on every block. The message thread reads it,
+    and workers only write activity once a submission is acknowledged.
+*/
+struct AudioThreadState
+{
+    CacheLinePadding leading;
+
+    std::atomic<int> activity { 0 };
+    std::atomic<bool> signalHot { false };
+    std::atomic<int64_t> currentActivityBlock { 0 };
+    std::atomic<int64_t> lastActiveBlockTimestamp { 0 };
+    std::atomic<int> currentWindowMilliseconds { 0 };   // for StatsExport; stored on active blocks and window rolls
+
+    // audio thread only
+    ActivityAccountant accountant;
+
+    CacheLinePadding trailing;
+};
+
+/** Written by the message thread and the workers, read-mostly everywhere,
+    including once per active block on the audio thread (deepIdle,
+    sharedActivityGroup).
+*/
+struct ControlState
+{
+    CacheLinePadding leading;
+
+    std::atomic<bool> connectionHealthy { true };
+    std::atomic<bool> sessionKeyValidated { false };
+    std::atomic<bool> currentSessionKeyInvalid { false };
+    std::atomic<bool> enableAnimation { true };
+    std::atomic<bool> deepIdle { false };
+    std::atomic<bool> sessionEndRequested { false };
+    std::atomic<bool> submissionInFlight { false };
+    std::atomic<uint32_t> sharedActivityGroup { 0 };
+
+    CacheLinePadding trailing;
+};
+
+static_assert (alignof (AudioThreadState) <= alignof (std::max_align_t) && alignof (ControlState) <= alignof (std::max_align_t),
+               "state blocks must not make the processor over-aligned");
@@ -0,0 +1,198 @@
+#pragma once
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Client-side rate limiter shared by every request type of every plugin
+    instance in the process (hold it through a juce::SharedResourcePointer).
+
+    Requests draw from one token bucket. When the server pushes back, with a
+    429/503, `Retry-After`, or an exhausted `RateLimit-*` / `X-RateLimit-*`
+    budget, the whole pipeline is paused until the given time instead of
+    every job sleeping and retrying on its own schedule.
+*/
+class RateLimiter
+{
+public:
+    RateLimiter() : lastRefillMs(juce::Time::getMillisecondCounterHiRes()) {}
+
+    /** Blocks the calling worker until a token is available and no pause is in
+        effect. Returns false if shouldAbort() became true while waiting.
+    */
+    bool acquire(const std::function<bool()>& shouldAbort)
+    {
+        for (;;) {
+            if (shouldAbort != nullptr && shouldAbort()) {
+                return false;
+            }
+
+            auto waitMs = tryTakeToken();
+            if (waitMs <= 0) {
+                return true;
+            }
+
+            juce::Thread::sleep(juce::jlimit(10, maxWaitSliceMs, waitMs));
+        }
+    }
+
+    /** Feeds a response back into the limiter, so the next acquire() honours
+        whatever the server asked for.
+    */
+    void recordResponse(int status, const juce::StringPairArray& headers)
+    {
+        const auto now = juce::Time::currentTimeMillis();
+
+        // only a number counts; getIntValue() would read a malformed value as 0 and pause
+        auto remaining = headerValue(headers, "RateLimit-Remaining", "X-RateLimit-Remaining");
+        if (remaining.isNotEmpty() && remaining.containsOnly("0123456789") && remaining.getLargeIntValue() <= 0) {
+            auto resetMs = parseResetMs(headerValue(headers, "RateLimit-Reset", "X-RateLimit-Reset"), now);
+            if (resetMs > 0) {
+                pauseFor(resetMs);
+            }
+        }
+
+        if (pausesPipeline(status)) {
+            auto throttled = consecutiveThrottles.fetch_add(1) + 1;
+            auto retryAfterMs = parseRetryAfterMs(headers, now);
+
+            DBG("Rate limiter: pausing pipeline (status " << status << ", Retry-After " << retryAfterMs << " ms)");
+            pauseFor(juce::jmax(retryAfterMs, getBackoffMs(throttled)));
+        }
+        else if (status >= 200 && status < 300) {
+            consecutiveThrottles.store(0);
+        }
+    }
+
+    /** Jittered exponential backoff, capped: a random delay in [d/2, d) with
+        d = min(cap, base * 2^(attempt - 1)).
+    */
+    int getBackoffMs(int attempt)
+    {
+        auto exponent = juce::jlimit(0, 16, attempt - 1);
+        auto ceiling = static_cast<int>(juce::jmin<int64_t>(maxBackoffMs, static_cast<int64_t>(baseBackoffMs) << exponent));
+
+        const juce::SpinLock::ScopedLockType lock(randomLock);
+        return ceiling / 2 + random.nextInt(juce::jmax(1, ceiling / 2));
+    }
+
+    bool isPaused() const { return juce::Time::currentTimeMillis() < pausedUntilMs.load(); }
+
+    /** Statuses that pause the pipeline in recordResponse(). Callers retry them
+        through acquire(), which already waits the pause out, without a backoff
+        sleep of their own on top.
+    */
+    static bool pausesPipeline(int status) { return status == 429 || status == 503; }
+
+    /** Parses `Retry-After` as delta-seconds or an HTTP-date; returns 0 if absent. */
+    static int parseRetryAfterMs(const juce::StringPairArray& headers, int64_t nowMs)
+    {
+        auto value = headers.getValue("Retry-After", {}).trim();
+        if (value.isEmpty()) {
+            return 0;
+        }
+
+        if (value.containsOnly("0123456789")) {
+            return static_cast<int>(juce::jmin<int64_t>(maxPauseMs, value.getLargeIntValue() * 1000));
+        }
+
+        auto date = parseHttpDate(value);
+        if (date == juce::Time()) {
+            return 0;
+        }
+        return static_cast<int>(juce::jlimit<int64_t>(0, maxPauseMs, date.toMilliseconds() - nowMs));
+    }
+
+private:
+    static constexpr double tokensPerSecond = 1.0;
+    static constexpr double bucketCapacity = 10.0;
+    static constexpr int baseBackoffMs = 1000;
+    static constexpr int maxBackoffMs = 5 * 60 * 1000;
+    static constexpr int64_t maxPauseMs = 60 * 60 * 1000;
+    static constexpr int maxWaitSliceMs = 250;
+
+    juce::SpinLock bucketLock;
+    double tokens = bucketCapacity;
+    double lastRefillMs;
+
+    std::atomic<int64_t> pausedUntilMs{0};
+    std::atomic<int> consecutiveThrottles{0};
+
+    juce::SpinLock randomLock;
+    juce::Random random;
+
+    /** Returns 0 if a token was taken, otherwise the ms until one may be available. */
+    int tryTakeToken()
+    {
+        auto pausedMs = pausedUntilMs.load() - juce::Time::currentTimeMillis();
+        if (pausedMs > 0) {
+            return static_cast<int>(pausedMs);
+        }
+
+        const juce::SpinLock::ScopedLockType lock(bucketLock);
+
+        auto now = juce::Time::getMillisecondCounterHiRes();
+        tokens = juce::jmin(bucketCapacity, tokens + (now - lastRefillMs) * 0.001 * tokensPerSecond);
+        lastRefillMs = now;
+
+        if (tokens >= 1.0) {
+            tokens -= 1.0;
+            return 0;
+        }
+        return static_cast<int>(std::ceil((1.0 - tokens) * 1000.0 / tokensPerSecond));
+    }
+
+    void pauseFor(int64_t durationMs)
+    {
+        auto until = juce::Time::currentTimeMillis() + juce::jmin(durationMs, maxPauseMs);
+        auto current = pausedUntilMs.load();
+        while (current < until && !pausedUntilMs.compare_exchange_weak(current, until)) {}
+    }
+
+    static juce::String headerValue(const juce::StringPairArray& headers, const char* name, const char* legacyName)
+    {
+        auto value = headers.getValue(name, {});
+        return value.isNotEmpty() ? value.trim() : headers.getValue(legacyName, {}).trim();
+    }
+
+    /** Reset headers are either a delay in seconds or, for some servers, an
+        absolute epoch time in seconds.
+    */
+    static int64_t parseResetMs(const juce::String& value, int64_t nowMs)
+    {
+        if (value.isEmpty()) {
+            return 0;
+        }
+
+        auto seconds = value.getLargeIntValue();
+        if (seconds > 1000000000) {
+            return juce::jmax<int64_t>(0, seconds * 1000 - nowMs);
+        }
+        return seconds * 1000;
+    }
+
+    /** RFC 7231 IMF-fixdate, e.g. "Wed, 21 Oct 2015 07:28:00 GMT". */
+    static juce::Time parseHttpDate(const juce::String& value)
+    {
+        auto parts = juce::StringArray::fromTokens(value.fromFirstOccurrenceOf(",", false, false), " :", "");
+        parts.removeEmptyStrings();
+        if (parts.size() < 6) {
+            return {};
+        }
+
+        static const juce::StringArray months { "jan", "feb", "mar", "apr", "may", "jun",
+                                                "jul", "aug", "sep", "oct", "nov", "dec" };
+        auto month = months.indexOf(parts[1].substring(0, 3).toLowerCase());
+        if (month < 0) {
+            return {};
+        }
+
+        return juce::Time(parts[2].getIntValue(), month, parts[0].getIntValue(),
+                          parts[3].getIntValue(), parts[4].getIntValue(), parts[5].getIntValue(),
+                          0, false);
+    }
+};
@@ -11,15 +11,38 @@
 #ifndef RESTREQUEST_H
 #define RESTREQUEST_H
 
+#include <array>
+#include <memory>
+#include <utility>
 #include <JuceHeader.h>
+#include "Tracer.h"
 
+/** Move-only request builder. Every builder call returns a reference to the same
+    request, so a chain such as `req.post (url).header (...).field (...)` neither
+    copies the request nor loses anything set along the way. Headers live in a
+    fixed array and the JSON body is serialised once, field by field, into a
+    pre-sized buffer.
+*/
 class RestRequest
 {
 public:
 
-    RestRequest (juce::String urlString) : url (urlString) {}
-    RestRequest (juce::URL url)          : url (url) {}
-    RestRequest () {}
+    RestRequest() = default;
+
+    RestRequest (RestRequest&&) = default;
+    RestRequest& operator= (RestRequest&&) = default;
+
+    /** How much of the response body execute() reads. */
+    enum class ResponseMode
+    {
+        statusOnly,     // status and headers only, the body is never read
+        boundedText,    // read at most maxBodyBytes into bodyAsString
+        boundedJSON     // as boundedText, then parse into body
+    };
+
+    static constexpr int defaultMaxBodyBytes = 64 * 1024;
+    static constexpr int maxHeaders = 6;
+    static constexpr size_t initialBodyBytes = 1024;
 
     struct Response
     {
@@ -30,31 +53,53 @@ public:
         int status;
 
         Response() : result (juce::Result::ok()), status (0) {}
-    } response;
+    };
 
-    RestRequest::Response execute ()
+    Response execute ()
     {
+        SIGNALBASH_TRACE_SCOPE ("http", "request");
+        Response response;
 
-        auto urlRequest = juce::URL(endpoint);
-        bool hasFields = (fields.getProperties().size() > 0);
+        auto urlRequest = juce::URL (endpoint);
+        bool hasFields = (numFields > 0);
         if (hasFields)
         {
-            juce::MemoryOutputStream output;
-            juce::JSON::FormatOptions jsonConfig;
-
-            fields.writeAsJSON (output, jsonConfig);
-            urlRequest = urlRequest.withPOSTData (output.toString());
+            closeBody();
+            urlRequest = urlRequest.withPOSTData (body->getMemoryBlock());
         }
 
         auto options = juce::URL::InputStreamOptions (hasFields ? juce::URL::ParameterHandling::inPostData : juce::URL::ParameterHandling::inAddress)
-           .withExtraHeaders (stringPairArrayToHeaderString(headers))
+           .withExtraHeaders (getHeaderString())
            .withConnectionTimeoutMs (30 * 1000)
            .withResponseHeaders (&response.headers)
            .withStatusCode (&response.status)
            .withNumRedirectsToFollow (5)
            .withHttpRequestCmd (verb);
 
-        std::unique_ptr<juce::InputStream> input (urlRequest.createInputStream (options));
+        // createInputStream connects, sends and waits for the response headers; the
+        // upload progress callback marks where connecting ends and sending starts
+        const auto connectStartMicros = Tracer::isEnabled() ? Tracer::nowMicros() : int64_t (-1);
+        int64_t sendStartMicros = -1;
+        auto markSendStart = [&sendStartMicros] (int, int)
+        {
+            if (sendStartMicros < 0)
+                sendStartMicros = Tracer::nowMicros();
+            return true;
+        };
+
+        std::unique_ptr<juce::InputStream> input (urlRequest.createInputStream (connectStartMicros >= 0 ? options.withProgressCallback (markSendStart)
+                                                                                                         : options));
+
+        if (connectStartMicros >= 0)
+        {
+            const auto headersMicros = Tracer::nowMicros();
+            const auto connectEndMicros = sendStartMicros >= 0 ? sendStartMicros : headersMicros;
+            Tracer::complete ("http", "connect", connectStartMicros, connectEndMicros);
+            if (sendStartMicros >= 0)
+                Tracer::complete ("http", "send", sendStartMicros, headersMicros);
+            if (input != nullptr)
+                Tracer::instant ("http", "firstByte");
+        }
 
         if (!input) {
             if (response.status == 0)
@@ -67,94 +112,152 @@ public:
         response.result = checkInputStream (input);
         if (response.result.failed()) return response;
 
-        response.bodyAsString = input->readEntireStreamAsString();
-        response.result = juce::JSON::parse(response.bodyAsString, response.body);
+        if (responseMode == ResponseMode::statusOnly) return response;
+
+        {
+            SIGNALBASH_TRACE_SCOPE ("http", "readBody");
+            response.result = readBoundedBody (*input, maxBodyBytes, response.bodyAsString);
+        }
+        if (response.result.failed()) return response;
+
+        if (responseMode == ResponseMode::boundedJSON)
+            response.result = juce::JSON::parse(response.bodyAsString, response.body);
 
         return response;
     }
 
-    RestRequest get (const juce::String& endpoint)
+    RestRequest& get (const juce::String& endpointToUse)  { return withVerb ("GET", endpointToUse); }
+    RestRequest& post (const juce::String& endpointToUse) { return withVerb ("POST", endpointToUse); }
+    RestRequest& put (const juce::String& endpointToUse)  { return withVerb ("PUT", endpointToUse); }
+    RestRequest& del (const juce::String& endpointToUse)  { return withVerb ("DELETE", endpointToUse); }
+
+    /** Appends one member to the JSON body. Names are expected to be unique. */
+    RestRequest& field (const juce::String& name, const juce::var& value)
     {
-        RestRequest req (*this);
-        req.verb = "GET";
-        req.endpoint = endpoint;
+        jassert (! bodyClosed); // fields can't follow closeBody() or execute()
+
+        if (body == nullptr)
+            body = std::make_unique<juce::MemoryOutputStream> (initialBodyBytes);
 
-        return req;
+        *body << (numFields++ == 0 ? '{' : ',');
+        juce::JSON::writeToStream (*body, juce::var (name), jsonFormat());
+        *body << ':';
+        juce::JSON::writeToStream (*body, value, jsonFormat());
+        return *this;
     }
 
-    RestRequest post (const juce::String& endpoint)
+    /** Ends the JSON object. execute() calls it, so an executed request can be
+        executed again (e.g. retried) with the same body; calling it again does
+        nothing.
+    */
+    RestRequest& closeBody()
     {
-        RestRequest req (*this);
-        req.verb = "POST";
-        req.endpoint = endpoint;
-
-        return req;
+        if (body != nullptr && ! bodyClosed)
+        {
+            *body << '}';
+            bodyClosed = true;
+        }
+        return *this;
     }
 
-    RestRequest put (const juce::String& endpoint)
+    /** Selects how the response body is handled; /ping and /submit only need the status. */
+    RestRequest& expect (ResponseMode mode, int maxBytes = defaultMaxBodyBytes)
     {
-        RestRequest req (*this);
-        req.verb = "PUT";
-        req.endpoint = endpoint;
-
-        return req;
+        responseMode = mode;
+        maxBodyBytes = maxBytes;
+        return *this;
     }
 
-    RestRequest del (const juce::String& endpoint)
+    /** Sets a header, replacing any earlier value for the same name. */
+    RestRequest& header (const juce::String& name, const juce::String& value)
     {
-        RestRequest req (*this);
-        req.verb = "DELETE";
-        req.endpoint = endpoint;
+        for (int i = 0; i < numHeaders; ++i)
+        {
+            if (headers[(size_t) i].first.equalsIgnoreCase (name))
+            {
+                headers[(size_t) i].second = value;
+                return *this;
+            }
+        }
 
-        return req;
-    }
+        jassert (numHeaders < maxHeaders); // raise maxHeaders if a request genuinely needs more
+        if (numHeaders < maxHeaders)
+            headers[(size_t) numHeaders++] = { name, value };
 
-    RestRequest field (const juce::String& name, const juce::var& value)
-    {
-        fields.setProperty(name, value);
         return *this;
     }
 
-    RestRequest header (const juce::String& name, const juce::String& value)
+    juce::String getBodyAsString() const
     {
-        RestRequest req (*this);
-        headers.set (name, value);
-        return req;
+        return body != nullptr ? body->toString() : juce::String();
     }
 
-    const juce::URL& getURL() const
+private:
+    std::array<std::pair<juce::String, juce::String>, maxHeaders> headers;
+    int numHeaders = 0;
+    const char* verb = "GET";
+    juce::String endpoint;
+    std::unique_ptr<juce::MemoryOutputStream> body;
+    int numFields = 0;
+    bool bodyClosed = false;
+    ResponseMode responseMode = ResponseMode::boundedJSON;
+    int maxBodyBytes = defaultMaxBodyBytes;
+
+    RestRequest& withVerb (const char* newVerb, const juce::String& endpointToUse)
     {
-        return url;
+        verb = newVerb;
+        endpoint = endpointToUse;
+        return *this;
     }
 
-    const juce::String& getBodyAsString() const
+    static juce::JSON::FormatOptions jsonFormat()
     {
-        return bodyAsString;
+        return juce::JSON::FormatOptions().withSpacing (juce::JSON::Spacing::none);
     }
 
-private:
-    juce::URL url;
-    juce::StringPairArray headers;
-    juce::String verb;
-    juce::String endpoint;
-    juce::DynamicObject fields;
-    juce::String bodyAsString;
-
     juce::Result checkInputStream (std::unique_ptr<juce::InputStream>& input)
     {
         if (! input) return juce::Result::fail ("HTTP request failed, check your internet connection");
         return juce::Result::ok();
     }
 
-    static juce::String stringPairArrayToHeaderString(juce::StringPairArray stringPairArray)
+    /** Reads up to maxBytes of the body into a per-thread buffer that is reused
+        across requests, failing instead of growing if the server sends more.
+    */
+    static juce::Result readBoundedBody (juce::InputStream& input, int maxBytes, juce::String& bodyAsString)
+    {
+        thread_local juce::MemoryBlock buffer;
+        buffer.ensureSize ((size_t) maxBytes + 1);
+
+        auto* data = static_cast<char*> (buffer.getData());
+        int total = 0;
+
+        while (total <= maxBytes)
+        {
+            auto numRead = input.read (data + total, maxBytes + 1 - total);
+            if (numRead <= 0) break;
+            total += numRead;
+        }
+
+        if (total > maxBytes)
+            return juce::Result::fail ("Response body exceeds " + juce::String (maxBytes) + " bytes");
+
+        bodyAsString = juce::String::fromUTF8 (data, total);
+        return juce::Result::ok();
+    }
+
+    juce::String getHeaderString() const
     {
         juce::String result;
-        for (auto key : stringPairArray.getAllKeys())
+        for (int i = 0; i < numHeaders; ++i)
         {
-            result += key + ": " + stringPairArray.getValue(key, "") + "\n";
+            const auto& [name, value] = headers[(size_t) i];
+            result << name << ": " << value << "\n";
         }
         return result;
     }
+
+    JUCE_DECLARE_NON_COPYABLE (RestRequest)
 };
 
 #endif
@@ -0,0 +1,247 @@
+#include "SessionKeyValidator.h"
+#include "RestRequest.h"
+#include "Tracer.h"
+
+namespace
+{
+    const char* toString (SessionKeyValidator::Verdict verdict)
+    {
+        return verdict == SessionKeyValidator::Verdict::valid ? "valid"
+             : verdict == SessionKeyValidator::Verdict::invalid ? "invalid"
+             : "unknown";
+    }
+}
+
+//==============================================================================
+SessionKeyValidator::SessionKeyValidator()
+{
+    fileLock = std::make_unique<juce::InterProcessLock> ("SignalbashSessionKeys");
+
+    juce::PropertiesFile::Options options;
+    options.applicationName     = "session_keys";
+    options.filenameSuffix      = "settings";
+    options.folderName          = "Signalbash";
+    options.osxLibrarySubFolder = "Application Support";
+    options.processLock         = fileLock.get();
+
+    auto cacheFile = juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory)
+                         .getChildFile (options.folderName)
+                         .getChildFile (options.applicationName + "." + options.filenameSuffix);
+    file = std::make_unique<juce::PropertiesFile> (cacheFile, options);
+
+    const auto& properties = file->getAllProperties();
+    for (int i = 0; i < properties.size(); ++i) {
+        auto value = properties.getAllValues()[i];
+        Entry entry { value.upToFirstOccurrenceOf (":", false, false) == "valid" ? Verdict::valid : Verdict::invalid,
+                      value.fromFirstOccurrenceOf (":", false, false).getLargeIntValue() };
+        entries[properties.getAllKeys()[i]] = entry;
+    }
+
+    startTimer (checkIntervalMs);
+}
+
+SessionKeyValidator::~SessionKeyValidator()
+{
+    stopTimer();
+    cancelPendingUpdate();
+    scheduler->cancelJobs (this, 5000);
+    handleAsyncUpdate();
+}
+
+void SessionKeyValidator::configure (const std::string& endpointToUse, const juce::String& version, const juce::String& agent)
+{
+    const juce::ScopedLock sl (lock);
+    endpoint = endpointToUse;
+    pluginVersion = version;
+    userAgent = agent;
+}
+
+juce::String SessionKeyValidator::hashKey (const juce::String& key)
+{
+    return "k" + juce::String::toHexString (key.toUpperCase().hashCode64());
+}
+
+int64_t SessionKeyValidator::nowMs()
+{
+    // wall clock: verdicts are compared across restarts
+    return juce::Time::currentTimeMillis();
+}
+
+//==============================================================================
+SessionKeyValidator::Verdict SessionKeyValidator::getVerdict (const juce::String& key) const
+{
+    const juce::ScopedLock sl (lock);
+    auto found = entries.find (hashKey (key));
+    if (found == entries.end() || nowMs() - found->second.checkedMs >= expireAfterMs) {
+        return Verdict::unknown;
+    }
+    return found->second.verdict;
+}
+
+void SessionKeyValidator::setKeyInUse (const void* owner, const juce::String& key)
+{
+    if (key.isEmpty()) {
+        keysInUse.erase (owner);
+    } else {
+        keysInUse[owner] = key;
+    }
+}
+
+void SessionKeyValidator::importLegacyVerdict (const juce::String& key, bool wasValid)
+{
+    if (!wasValid) {
+        return;
+    }
+
+    {
+        const juce::ScopedLock sl (lock);
+        auto hashedKey = hashKey (key);
+        if (entries.count (hashedKey) != 0) {
+            return;
+        }
+
+        // trusted now, but due for a background check on the next tick
+        entries[hashedKey] = { Verdict::valid, nowMs() - refreshAfterMs };
+        dirty = true;
+    }
+    triggerAsyncUpdate();
+}
+
+void SessionKeyValidator::validate (const juce::String& key, bool evenIfFresh)
+{
+    if (key.isEmpty()) {
+        return;
+    }
+
+    auto hashedKey = hashKey (key);
+    if (!evenIfFresh) {
+        const juce::ScopedLock sl (lock);
+        auto found = entries.find (hashedKey);
+        if (found != entries.end() && found->second.verdict != Verdict::unknown && nowMs() - found->second.checkedMs < refreshAfterMs) {
+            return;
+        }
+    }
+
+    request (key, hashedKey);
+}
+
+//==============================================================================
+void SessionKeyValidator::request (const juce::String& key, const juce::String& hashedKey)
+{
+    std::string url;
+    juce::String version, agent;
+    {
+        const juce::ScopedLock sl (lock);
+        if (endpoint.empty() || !inFlight.insert (hashedKey).second) {
+            return;
+        }
+        url = endpoint;
+        version = pluginVersion;
+        agent = userAgent;
+    }
+
+    DBG("Validating session key");
+
+    // jobs are cancelled in the destructor, so capturing this is safe
+    scheduler->submit (this, "validateSessionKey", [this, key, hashedKey, url, version, agent] {
+        const juce::ScopeGuard clearInFlight { [this, hashedKey] {
+            const juce::ScopedLock sl (lock);
+            inFlight.erase (hashedKey);
+        } };
+
+        juce::ignoreUnused (agent);
+        const int maxAttempts = 5;
+        for (int attempt = 1; attempt <= maxAttempts; ++attempt) {
+            if (!rateLimiter->acquire ([] { return BackgroundScheduler::currentJobShouldExit(); })) return;
+
+            RestRequest request;
+            request.header ("Content-Type", "application/json");
+           #if JUCE_WINDOWS
+            request.header ("User-Agent", agent);
+           #endif
+            RestRequest::Response response = request.post (url)
+                .field ("plugin_version", version)
+                .field ("session_key", key)
+                .expect (RestRequest::ResponseMode::statusOnly)
+                .execute();
+            rateLimiter->recordResponse (response.status, response.headers);
+            connection->reportResponse (response.status);
+
+            if (response.status == 200) {
+                store (hashedKey, Verdict::valid);
+                return;
+            }
+            if (response.status == 404) {
+                store (hashedKey, Verdict::invalid);
+                return;
+            }
+            if (response.status == 0) {
+                // keep the cached verdict; instances retry once the monitor sees the server again
+                DBG("Session key validation: no connection");
+                return;
+            }
+            if (!RateLimiter::pausesPipeline (response.status)) {
+                DBG("Session key validation: status " << response.status << ", retrying");
+                if (!BackgroundScheduler::sleep (rateLimiter->getBackoffMs (attempt))) return;
+            }
+        }
+    });
+}
+
+void SessionKeyValidator::store (const juce::String& hashedKey, Verdict verdict)
+{
+    {
+        const juce::ScopedLock sl (lock);
+        entries[hashedKey] = { verdict, nowMs() };
+        dirty = true;
+    }
+
+    DBG("Session key " << toString (verdict));
+    SIGNALBASH_TRACE_INSTANT ("network", "sessionKeyVerdict");
+    triggerAsyncUpdate();
+}
+
+//==============================================================================
+void SessionKeyValidator::timerCallback()
+{
+    // keys in use whose verdict is getting old are confirmed in the background
+    std::set<juce::String> keys;
+    for (const auto& [owner, key] : keysInUse) {
+        keys.insert (key);
+    }
+    for (const auto& key : keys) {
+        validate (key);
+    }
+}
+
+void SessionKeyValidator::handleAsyncUpdate()
+{
+    {
+        const juce::ScopedLock sl (lock);
+        if (!dirty) {
+            return;
+        }
+        dirty = false;
+
+        // another process may have written since we loaded; the newer verdict for each key wins
+        file->reload();
+        const auto& properties = file->getAllProperties();
+        for (int i = 0; i < properties.size(); ++i) {
+            auto value = properties.getAllValues()[i];
+            auto checkedMs = value.fromFirstOccurrenceOf (":", false, false).getLargeIntValue();
+            auto& entry = entries[properties.getAllKeys()[i]];
+            if (checkedMs > entry.checkedMs) {
+                entry = { value.upToFirstOccurrenceOf (":", false, false) == "valid" ? Verdict::valid : Verdict::invalid, checkedMs };
+            }
+        }
+
+        for (const auto& [hashedKey, entry] : entries) {
+            if (entry.verdict != Verdict::unknown) {
+                file->setValue (hashedKey, juce::String (toString (entry.verdict)) + ":" + juce::String (entry.checkedMs));
+            }
+        }
+        file->saveIfNeeded();
+    }
+
+    sendChangeMessage();
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <JuceHeader.h>
+#include "BackgroundScheduler.h"
+#include "ConnectionMonitor.h"
+#include "RateLimiter.h"
+
+//==============================================================================
+/**
+    Process-wide cache of session key validation results (hold it through a
+    juce::SharedResourcePointer), so opening a project answers from disk
+    instead of asking the API once per instance.
+
+    Each key's verdict is stored with the time it was last confirmed, in a
+    settings file of its own (keys are stored hashed), shared by every
+    process under an inter-process lock:
+
+    - getVerdict() never touches the network. A verdict is trusted for
+      expireAfterMs; past that the key is unknown again.
+    - keys that instances have in use are revalidated in the background once
+      their verdict is older than refreshAfterMs, so a revoked key stops
+      showing as valid within about refreshAfterMs plus one check interval
+      while the API is reachable.
+    - validate() is single-flight per key: however many instances ask, one
+      request is in flight, and everyone is told when it resolves.
+
+    Listeners get a change message on the message thread whenever a verdict
+    changes.
+*/
+class SessionKeyValidator : public juce::ChangeBroadcaster,
+                            private juce::Timer,
+                            private juce::AsyncUpdater
+{
+public:
+    enum class Verdict
+    {
+        unknown,
+        valid,
+        invalid
+    };
+
+    SessionKeyValidator();
+    ~SessionKeyValidator() override;
+
+    /** Where and how to validate. The request fields are the same for every instance. */
+    void configure (const std::string& endpoint, const juce::String& pluginVersion, const juce::String& userAgent);
+
+    /** The cached verdict. Never blocks on the network. */
+    Verdict getVerdict (const juce::String& key) const;
+
+    /** Registers the key an instance uses (empty to clear), so it's kept fresh in the background. */
+    void setKeyInUse (const void* owner, const juce::String& key);
+
+    /** Seeds a verdict from the old per-key "_validity" setting, if none is cached yet. */
+    void importLegacyVerdict (const juce::String& key, bool wasValid);
+
+    /** Asks the API unless a fresh verdict is cached or a request for the key is already in flight. */
+    void validate (const juce::String& key, bool evenIfFresh = false);
+
+    static constexpr int64_t refreshAfterMs = 60 * 60 * 1000;                // 1 hour
+    static constexpr int64_t expireAfterMs = 7 * 24 * 60 * 60 * 1000LL;      // 1 week
+    static constexpr int checkIntervalMs = 5 * 60 * 1000;
+
+private:
+    struct Entry
+    {
+        Verdict verdict = Verdict::unknown;
+        int64_t checkedMs = 0;
+    };
+
+    mutable juce::CriticalSection lock;
+    std::map<juce::String, Entry> entries;             // by hashed key
+    std::set<juce::String> inFlight;                   // by hashed key
+    std::map<const void*, juce::String> keysInUse;     // message thread only
+    bool dirty = false;
+
+    std::string endpoint;
+    juce::String pluginVersion, userAgent;
+
+    std::unique_ptr<juce::InterProcessLock> fileLock;
+    std::unique_ptr<juce::PropertiesFile> file;
+
+    juce::SharedResourcePointer<BackgroundScheduler> scheduler;
+    juce::SharedResourcePointer<RateLimiter> rateLimiter;
+    juce::SharedResourcePointer<ConnectionMonitor> connection;
+
+    static juce::String hashKey (const juce::String& key);
+    static int64_t nowMs();
+    void store (const juce::String& hashedKey, Verdict verdict);
+    void request (const juce::String& key, const juce::String& hashedKey);
+
+    void timerCallback() override;
+    void handleAsyncUpdate() override;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SessionKeyValidator)
+};
@@ -0,0 +1,466 @@
+#include <array>
+#include <bit>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "SharedActivitySegment.h"
+
+#if JUCE_LINUX
+ #include <fcntl.h>
+ #include <sys/mman.h>
+ #include <sys/stat.h>
+ #include <unistd.h>
+#endif
+
+static_assert (std::atomic<int64_t>::is_always_lock_free, "shared segment needs lock-free 64-bit atomics");
+static_assert (std::atomic<uint64_t>::is_always_lock_free, "shared segment needs lock-free 64-bit atomics");
+
+namespace
+{
+    constexpr uint32_t segmentMagic = 0x53424153; // "SBAS"
+    constexpr uint32_t segmentVersion = 4;
+
+    // window states: 0 = free, > 0 = tag of the window's group and start, harvesting = being emptied
+    constexpr int64_t harvesting = -1;
+    constexpr int maxProbes = 8;
+
+    // groups stay below 2^31 (see groupFor), so a tag is always positive
+    int64_t tagFor (uint32_t group, int64_t windowTimestamp)
+    {
+        return (static_cast<int64_t> (group) << 32) | (windowTimestamp / SharedActivitySegment::windowSeconds);
+    }
+
+    uint32_t groupOf (int64_t tag)
+    {
+        return static_cast<uint32_t> (tag >> 32);
+    }
+
+    int64_t timestampOf (int64_t tag)
+    {
+        return (tag & 0xffffffff) * SharedActivitySegment::windowSeconds;
+    }
+
+    std::string segmentNameOverride;
+}
+
+//==============================================================================
+struct SharedActivitySegment::WindowSlot
+{
+    std::atomic<int64_t> tag;
+    std::atomic<int32_t> writers;                       // markers between their tag check and their last fetch_or
+    std::atomic<uint64_t> occupancy[occupancyWords];   // one bit per slotMs of the window
+};
+
+struct SharedActivitySegment::Layout
+{
+    std::atomic<uint32_t> magic;
+    std::atomic<uint32_t> version;
+
+    struct ParticipantSlot
+    {
+        std::atomic<uint64_t> token;
+        std::atomic<int64_t> heartbeatMs;
+        std::atomic<uint32_t> group;
+    };
+
+    ParticipantSlot participants[maxParticipants];
+    WindowSlot windows[numWindows];
+};
+
+//==============================================================================
+SharedActivitySegment::SharedActivitySegment()
+{
+    if (!openShared()) {
+        // zero-initialised, which is the valid empty state
+        localLayout.reset (new Layout());
+        layout = localLayout.get();
+        layout->magic.store (segmentMagic);
+        layout->version.store (segmentVersion);
+    }
+
+    DBG("Shared activity segment: " << (shared ? "cross-process" : "process-local"));
+}
+
+SharedActivitySegment::~SharedActivitySegment()
+{
+   #if JUCE_LINUX
+    if (mapping != nullptr) {
+        munmap (mapping, mappingSize);
+    }
+   #endif
+}
+
+void SharedActivitySegment::useSegmentName (const std::string& name)
+{
+    segmentNameOverride = name;
+}
+
+bool SharedActivitySegment::openShared()
+{
+   #if JUCE_LINUX
+    auto name = !segmentNameOverride.empty() ? segmentNameOverride
+                                             : "/signalbash-activity-v" + std::to_string (segmentVersion) + "-" + std::to_string (getuid());
+    mappingSize = sizeof (Layout);
+
+    bool created = true;
+    int fd = shm_open (name.c_str(), O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+    if (fd < 0) {
+        created = false;
+        fd = shm_open (name.c_str(), O_RDWR, S_IRUSR | S_IWUSR);
+    }
+    if (fd < 0) {
+        return false;
+    }
+
+    if (created && ftruncate (fd, static_cast<off_t>(mappingSize)) != 0) {
+        close (fd);
+        shm_unlink (name.c_str());
+        return false;
+    }
+
+    // a concurrent creator may not have sized the object yet
+    struct stat info {};
+    for (int i = 0; i < 100 && fstat (fd, &info) == 0 && static_cast<size_t>(info.st_size) < mappingSize; ++i) {
+        juce::Thread::sleep (10);
+    }
+    if (static_cast<size_t>(info.st_size) != mappingSize) {
+        close (fd);
+        return false;
+    }
+
+    mapping = mmap (nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close (fd);
+    if (mapping == MAP_FAILED) {
+        mapping = nullptr;
+        return false;
+    }
+
+    layout = static_cast<Layout*>(mapping);
+
+    if (created) {
+        layout->version.store (segmentVersion);
+        layout->magic.store (segmentMagic, std::memory_order_release);
+    } else {
+        for (int i = 0; i < 100 && layout->magic.load (std::memory_order_acquire) != segmentMagic; ++i) {
+            juce::Thread::sleep (10);
+        }
+    }
+
+    if (layout->magic.load (std::memory_order_acquire) != segmentMagic || layout->version.load() != segmentVersion) {
+        DBG("Shared activity segment has an unknown layout, staying process-local");
+        munmap (mapping, mappingSize);
+        mapping = nullptr;
+        layout = nullptr;
+        return false;
+    }
+
+    shared = true;
+    return true;
+   #else
+    return false;
+   #endif
+}
+
+//==============================================================================
+uint32_t SharedActivitySegment::groupFor (const juce::String& host, const juce::String& sessionKey)
+{
+    if (sessionKey.isEmpty()) {
+        return 0;
+    }
+
+    // FNV-1a over host and key; every process computes the same group for the same pair
+    uint32_t h = 2166136261u;
+    auto mixIn = [&h] (const juce::String& text)
+    {
+        for (auto* p = text.toRawUTF8(); *p != 0; ++p) {
+            h ^= static_cast<unsigned char> (*p);
+            h *= 16777619u;
+        }
+        h ^= 0xffu;
+        h *= 16777619u;
+    };
+    mixIn (host);
+    mixIn (sessionKey);
+
+    h &= 0x7fffffffu;
+    return h != 0 ? h : 1;
+}
+
+//==============================================================================
+int64_t SharedActivitySegment::nowMs()
+{
+    // steady_clock is CLOCK_MONOTONIC on Linux, so heartbeats compare across processes
+    return std::chrono::duration_cast<std::chrono::milliseconds> (std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool SharedActivitySegment::isAlive (int slot, int64_t now) const
+{
+    const auto& p = layout->participants[slot];
+    return p.token.load (std::memory_order_acquire) != 0
+        && now - p.heartbeatMs.load (std::memory_order_relaxed) < heartbeatTimeoutMs;
+}
+
+SharedActivitySegment::Participant SharedActivitySegment::join (uint32_t group)
+{
+    static std::atomic<uint32_t> joinCounter { 0 };
+   #if JUCE_LINUX
+    const auto processTag = static_cast<uint64_t>(getpid());
+   #else
+    // process-local layout, any tag distinct from other instances will do
+    const auto processTag = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(&joinCounter) >> 4);
+   #endif
+    const auto token = (processTag << 32) | (joinCounter.fetch_add (1) + 1);
+    const auto now = nowMs();
+
+    for (int slot = 0; slot < maxParticipants; ++slot) {
+        auto& p = layout->participants[slot];
+        auto current = p.token.load();
+
+        if (current != 0 && isAlive (slot, now)) {
+            continue;
+        }
+
+        // published only once the slot is ours, so a joiner that loses the CAS can't
+        // overwrite the winner's group; heartbeat() re-stores both, in case one that
+        // lost a takeover race wrote them before noticing
+        if (p.token.compare_exchange_strong (current, token)) {
+            p.heartbeatMs.store (now);
+            p.group.store (group);
+            if (p.token.load() == token) {
+                return { slot, token, group };
+            }
+        }
+    }
+
+    DBG("Shared activity segment: no free participant slot");
+    return {};
+}
+
+void SharedActivitySegment::leave (Participant& participant)
+{
+    if (!participant.isValid()) {
+        return;
+    }
+
+    auto expected = participant.token;
+    layout->participants[participant.slot].token.compare_exchange_strong (expected, 0);
+    participant = {};
+}
+
+void SharedActivitySegment::setGroup (Participant& participant, uint32_t group)
+{
+    participant.group = group;
+    if (participant.isValid() && layout->participants[participant.slot].token.load() == participant.token) {
+        layout->participants[participant.slot].group.store (group);
+    }
+}
+
+void SharedActivitySegment::heartbeat (Participant& participant)
+{
+    if (participant.isValid()) {
+        auto& p = layout->participants[participant.slot];
+        if (p.token.load() == participant.token) {
+            p.heartbeatMs.store (nowMs());
+            p.group.store (participant.group);
+            return;
+        }
+        DBG("Shared activity segment: participant slot was taken over, re-joining");
+    }
+
+    const auto group = participant.group;
+    participant = join (group);
+    participant.group = group;
+}
+
+bool SharedActivitySegment::isLeader (const Participant& participant) const
+{
+    if (!participant.isValid() || participant.group == 0
+        || layout->participants[participant.slot].token.load() != participant.token) {
+        return false;
+    }
+
+    const auto now = nowMs();
+    for (int slot = 0; slot < participant.slot; ++slot) {
+        if (isAlive (slot, now) && layout->participants[slot].group.load() == participant.group) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//==============================================================================
+SharedActivitySegment::WindowSlot* SharedActivitySegment::claimWindow (uint32_t group, int64_t windowTimestamp)
+{
+    jassert (windowTimestamp > 0 && group != 0);
+    const auto tag = tagFor (group, windowTimestamp);
+    const auto base = static_cast<int>((windowTimestamp / windowSeconds + group) % numWindows);
+
+    for (int probe = 0; probe < maxProbes; ++probe) {
+        auto& w = layout->windows[(base + probe) % numWindows];
+        auto current = w.tag.load (std::memory_order_acquire);
+
+        // left by a group nobody has used for a week; nobody will harvest it now
+        if (current > 0 && current != tag && timestampOf (current) + orphanAfterSeconds < windowTimestamp
+            && w.tag.compare_exchange_strong (current, harvesting)) {
+            if (w.writers.load() != 0) {
+                // someone still writes to it after all; never wait on the audio thread
+                w.tag.store (current, std::memory_order_release);
+                continue;
+            }
+            for (auto& word : w.occupancy) {
+                word.store (0, std::memory_order_relaxed);
+            }
+            current = 0;
+            w.tag.store (0, std::memory_order_release);
+        }
+
+        if (current == 0 && !w.tag.compare_exchange_strong (current, tag)) {
+            // lost the claim; `current` now holds the winner's window
+        } else if (current == 0) {
+            current = tag;
+        }
+
+        if (current == tag) {
+            return &w;
+        }
+    }
+    return nullptr;
+}
+
+bool SharedActivitySegment::setSlots (WindowSlot& w, int64_t tag, int firstSlot, int endSlot)
+{
+    // announced before the tag is checked (both seq_cst), so a harvest either sees
+    // this writer and waits for it, or this writer sees the harvest and backs off;
+    // a late fetch_or can't leave bits behind in a window that was already emptied
+    w.writers.fetch_add (1);
+    if (w.tag.load() != tag) {
+        w.writers.fetch_sub (1, std::memory_order_release);
+        return false;
+    }
+
+    for (int word = firstSlot / 64; word * 64 < endSlot; ++word) {
+        const auto lo = juce::jmax (firstSlot, word * 64) - word * 64;
+        const auto hi = juce::jmin (endSlot, word * 64 + 64) - word * 64;
+        const auto mask = (hi - lo == 64) ? ~uint64_t { 0 } : (((uint64_t { 1 } << (hi - lo)) - 1) << lo);
+
+        // slots already marked by another instance need no write, which keeps hot
+        // windows from bouncing between cores when many tracks play at once
+        if ((w.occupancy[word].load (std::memory_order_relaxed) & mask) != mask) {
+            w.occupancy[word].fetch_or (mask, std::memory_order_relaxed);
+        }
+    }
+
+    w.writers.fetch_sub (1, std::memory_order_release);
+    return true;
+}
+
+bool SharedActivitySegment::markSlots (uint32_t group, int64_t windowTimestamp, int firstSlot, int endSlot)
+{
+    const auto tag = tagFor (group, windowTimestamp);
+
+    // a window harvested between the claim and the write is claimed afresh, once
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        auto* w = claimWindow (group, windowTimestamp);
+        if (w == nullptr) {
+            return false;
+        }
+        if (setSlots (*w, tag, firstSlot, endSlot)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SharedActivitySegment::markActive (uint32_t group, int64_t startMs, int64_t endMs)
+{
+    if (group == 0) {
+        return false;
+    }
+
+    constexpr int64_t windowMs = windowSeconds * 1000;
+    bool allMarked = true;
+
+    while (startMs < endMs) {
+        const auto windowStartMs = startMs - startMs % windowMs;
+        const auto spanEndMs = juce::jmin (endMs, windowStartMs + windowMs);
+
+        const auto first = static_cast<int>((startMs - windowStartMs) / slotMs);
+        const auto end = static_cast<int>((spanEndMs - windowStartMs + slotMs - 1) / slotMs);
+        allMarked = markSlots (group, windowStartMs / 1000, first, end) && allMarked;
+
+        startMs = spanEndMs;
+    }
+    return allMarked;
+}
+
+bool SharedActivitySegment::publish (uint32_t group, int64_t windowTimestamp, int milliseconds)
+{
+    if (group == 0) {
+        return false;
+    }
+
+    return markSlots (group, windowTimestamp, 0, juce::jlimit (0, slotsPerWindow, (milliseconds + slotMs - 1) / slotMs));
+}
+
+void SharedActivitySegment::harvest (uint32_t group, int64_t cutoffTimestamp, const std::function<void (int64_t, int)>& onWindow)
+{
+    if (group == 0) {
+        return;
+    }
+
+    // a marker retrying after a harvest can claim a second slot for the same window,
+    // so every slot of a window is taken first and their bits are united
+    std::vector<std::pair<WindowSlot*, int64_t>> taken;
+    for (auto& w : layout->windows) {
+        auto current = w.tag.load (std::memory_order_acquire);
+        if (current <= 0 || groupOf (current) != group || timestampOf (current) >= cutoffTimestamp) {
+            continue;
+        }
+
+        if (w.tag.compare_exchange_strong (current, harvesting)) {
+            taken.emplace_back (&w, current);
+        }
+    }
+
+    // a marker that checked the tag before the CAS is a few fetch_ors from done; one
+    // that is still counted was preempted (or died) mid-write, and its window is
+    // handed back whole and taken again on a later harvest rather than waited for
+    std::set<int64_t> busy;
+    for (auto& [w, tag] : taken) {
+        for (int spin = 0; spin < writerSpins && w->writers.load() != 0; ++spin) {
+            std::this_thread::yield();
+        }
+        if (w->writers.load() != 0) {
+            busy.insert (tag);
+        }
+    }
+
+    std::map<int64_t, std::array<uint64_t, occupancyWords>> windows;
+    for (auto& [w, tag] : taken) {
+        if (busy.count (tag) > 0) {
+            w->tag.store (tag, std::memory_order_release);
+            continue;
+        }
+
+        auto& bits = windows.try_emplace (timestampOf (tag)).first->second;
+        for (int word = 0; word < occupancyWords; ++word) {
+            bits[(size_t) word] |= w->occupancy[word].exchange (0);
+        }
+        w->tag.store (0, std::memory_order_release);
+    }
+
+    for (const auto& [timestamp, bits] : windows) {
+        int occupied = 0;
+        for (auto word : bits) {
+            occupied += std::popcount (word);
+        }
+        if (occupied > 0) {
+            onWindow (timestamp, occupied * slotMs);
+        }
+    }
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Per-user segment through which every Signalbash instance on the machine
+    merges its per-window activity, so hosts that sandbox plugins in separate
+    processes still produce a single submission per window.
+
+    On Linux the segment is a POSIX shared-memory object (`shm_open`); elsewhere,
+    or if it cannot be opened, it falls back to process-local memory shared by
+    the instances of this process. The layout is fixed-size and lock-free:
+
+    - activity is merged per group, one group per host and session key (see
+      groupFor()), because a group's union is submitted under its leader's
+      key; instances on other keys or hosts must not be merged into it.
+    - participants claim a slot, record their group and refresh a heartbeat
+      from the message thread. In each group, the live participant with the
+      lowest slot index is the leader and the only one that submits; a
+      participant whose heartbeat stops is replaced. Participants without a
+      session key (group 0) never lead and never merge, so they keep their
+      time to themselves until a key is set.
+    - windows are claimed by group and timestamp in an open-addressed ring;
+      publishers merge into them with atomics (safe on the audio thread) and
+      each group's leader harvests that group's closed windows into its own
+      backlog. A window left behind by a group nobody uses any more is
+      reclaimed once it is orphanAfterSeconds old.
+
+    Hold it through a juce::SharedResourcePointer.
+*/
+class SharedActivitySegment
+{
+public:
+    SharedActivitySegment();
+    ~SharedActivitySegment();
+
+    struct Participant
+    {
+        int slot = -1;
+        uint64_t token = 0;
+        uint32_t group = 0;
+
+        bool isValid() const { return slot >= 0; }
+    };
+
+    /** The group for a host and session key; 0, which never merges, without a key. */
+    static uint32_t groupFor (const juce::String& host, const juce::String& sessionKey);
+
+    /** Claims a participant slot in a group. Returns an invalid participant if all are taken. */
+    Participant join (uint32_t group);
+    void leave (Participant& participant);
+
+    /** Moves a participant to another group, e.g. when its session key changes. */
+    void setGroup (Participant& participant, uint32_t group);
+
+    /** Refreshes the heartbeat and the slot's group, re-joining if the slot was
+        taken over while this participant was unresponsive (e.g. the process was
+        suspended).
+    */
+    void heartbeat (Participant& participant);
+
+    /** True for the live participant with the lowest slot in its group; never in group 0. */
+    bool isLeader (const Participant& participant) const;
+
+    /** Marks the wall-clock span [startMs, endMs) as active in a group. Each window
+        keeps one occupancy bit per slotMs, so instances playing at the same time set
+        the same bits and overlapping time is only counted once. Wait-free (a bounded
+        probe plus one fetch_or per touched word, retried once if the window is
+        harvested meanwhile); safe on the audio thread.
+        Returns false if a window slot could not be claimed, and always in group 0.
+    */
+    bool markActive (uint32_t group, int64_t startMs, int64_t endMs);
+
+    /** Adds an already-aggregated window to a group, e.g. one handed back before
+        submission. Marks the first `milliseconds` worth of slots, so the total is
+        preserved. Returns false in group 0.
+    */
+    bool publish (uint32_t group, int64_t windowTimestamp, int milliseconds);
+
+    /** Removes every window of the group that started before cutoffTimestamp,
+        passing each to onWindow with its occupied time (popcount * slotMs).
+        A window a marker is still writing to is left for the next harvest, so
+        this never waits on another thread; call it outside any lock the audio
+        thread takes.
+    */
+    void harvest (uint32_t group, int64_t cutoffTimestamp, const std::function<void (int64_t, int)>& onWindow);
+
+    /** True if the segment is shared across processes, false if it is process-local. */
+    bool isShared() const { return shared; }
+
+    /** Opens a segment of this name instead of the per-user one, so tools
+        don't join (or disturb) the plugins actually running on the machine.
+        Call before the first segment is created.
+    */
+    static void useSegmentName (const std::string& name);
+
+    static constexpr int maxParticipants = 64;
+    static constexpr int numWindows = 1024;
+    static constexpr int64_t windowSeconds = 10;
+    static constexpr int slotMs = 10;
+    static constexpr int slotsPerWindow = static_cast<int>(windowSeconds * 1000 / slotMs);
+    static constexpr int occupancyWords = (slotsPerWindow + 63) / 64;
+    static constexpr int64_t heartbeatTimeoutMs = 10 * 1000;
+    static constexpr int writerSpins = 64;
+    static constexpr int64_t orphanAfterSeconds = 7 * 24 * 60 * 60;
+
+private:
+    struct Layout;
+    struct WindowSlot;
+
+    Layout* layout = nullptr;
+    bool shared = false;
+    void* mapping = nullptr;
+    size_t mappingSize = 0;
+    std::unique_ptr<Layout> localLayout;
+
+    bool openShared();
+    WindowSlot* claimWindow (uint32_t group, int64_t windowTimestamp);
+    bool markSlots (uint32_t group, int64_t windowTimestamp, int firstSlot, int endSlot);
+    static bool setSlots (WindowSlot& window, int64_t tag, int firstSlot, int endSlot);
+    static int64_t nowMs();
+    bool isAlive (int slot, int64_t now) const;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SharedActivitySegment)
+};
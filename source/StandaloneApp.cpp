@@ -0,0 +1,292 @@
+#include <JuceHeader.h>
+
+// Only built into the Standalone on Linux, where JUCE_USE_CUSTOM_PLUGIN_STANDALONE_APP is set
+// (see the top-level CMakeLists.txt); everywhere else JUCE's own standalone app is used unchanged.
+#if JucePlugin_Build_Standalone && JUCE_USE_CUSTOM_PLUGIN_STANDALONE_APP
+
+#include <csignal>
+#include <iostream>
+#include <juce_audio_plugin_client/Standalone/juce_StandaloneFilterWindow.h>
+
+//==============================================================================
+/**
+    Runs the processor straight off an audio input with no window, editor or
+    plugin host: `Signalbash --headless` tracks activity on hardware rigs and
+    outboard sessions with the same detector, accounting and submission code
+    as the plugin.
+
+    The device is opened input-only, with a large buffer so the detector's
+    SIMD pass runs on long blocks and the thread wakes rarely. Every few
+    seconds the measured callback load is checked against a CPU budget; while
+    it's over, the buffer is stepped up to the next size the device offers.
+*/
+class HeadlessMonitor : private juce::Timer
+{
+public:
+    struct Options
+    {
+        juce::String deviceType;        // empty: JACK if it has devices, else ALSA
+        juce::String deviceName;        // empty: the type's default input
+        int numInputChannels = 2;
+        double sampleRate = 0.0;        // 0: the device's default
+        int bufferSize = 4096;
+        double cpuBudget = 0.01;        // fraction of the audio callback's real time
+
+        static Options fromArguments (const juce::ArgumentList& args)
+        {
+            Options options;
+            if (args.containsOption ("--device-type")) options.deviceType = args.getValueForOption ("--device-type");
+            if (args.containsOption ("--device"))      options.deviceName = args.getValueForOption ("--device");
+            if (args.containsOption ("--channels"))    options.numInputChannels = juce::jlimit (1, 64, args.getValueForOption ("--channels").getIntValue());
+            if (args.containsOption ("--sample-rate")) options.sampleRate = args.getValueForOption ("--sample-rate").getDoubleValue();
+            if (args.containsOption ("--buffer-size")) options.bufferSize = juce::jmax (64, args.getValueForOption ("--buffer-size").getIntValue());
+            if (args.containsOption ("--cpu-budget"))  options.cpuBudget = juce::jlimit (0.001, 1.0, args.getValueForOption ("--cpu-budget").getDoubleValue() / 100.0);
+            return options;
+        }
+    };
+
+    ~HeadlessMonitor() override
+    {
+        stopTimer();
+        deviceManager.removeAudioCallback (&player);
+        player.setProcessor (nullptr);
+        deviceManager.closeAudioDevice();
+    }
+
+    /** Opens the device and starts processing. Returns an error message on failure. */
+    juce::String start (const Options& optionsToUse)
+    {
+        options = optionsToUse;
+
+        auto typeName = options.deviceType.isNotEmpty() ? options.deviceType : pickDeviceType();
+        if (typeName.isEmpty()) {
+            return "No audio device types available";
+        }
+        deviceManager.setCurrentAudioDeviceType (typeName, false);
+
+        juce::AudioDeviceManager::AudioDeviceSetup setup;
+        setup.inputDeviceName = options.deviceName;
+        setup.useDefaultInputChannels = true;
+        setup.useDefaultOutputChannels = false;
+        setup.sampleRate = options.sampleRate;
+        setup.bufferSize = options.bufferSize;
+
+        auto error = deviceManager.initialise (options.numInputChannels, 0, nullptr, false, {}, &setup);
+        if (error.isNotEmpty()) {
+            return error;
+        }
+
+        auto* device = deviceManager.getCurrentAudioDevice();
+        if (device == nullptr) {
+            return "Could not open an input on " + typeName;
+        }
+
+        processor.reset (juce::createPluginFilterOfType (juce::AudioProcessor::wrapperType_Standalone));
+        player.setProcessor (processor.get());
+        deviceManager.addAudioCallback (&player);
+
+        log ("Monitoring " + typeName + " \"" + device->getName() + "\", "
+             + juce::String (device->getActiveInputChannels().countNumberOfSetBits()) + " channels at "
+             + juce::String (device->getCurrentSampleRate(), 0) + " Hz, " + juce::String (device->getCurrentBufferSizeSamples())
+             + " samples per block, CPU budget " + juce::String (options.cpuBudget * 100.0, 1) + "%");
+
+        startTimer (signalPollMs);
+        return {};
+    }
+
+    static void listDevices()
+    {
+        juce::AudioDeviceManager manager;
+        for (auto* type : manager.getAvailableDeviceTypes()) {
+            type->scanForDevices();
+            std::cout << type->getTypeName() << std::endl;
+            for (auto& name : type->getDeviceNames (true)) {
+                std::cout << "  " << name << std::endl;
+            }
+        }
+    }
+
+    static void log (const juce::String& message)
+    {
+        std::cout << message << std::endl;
+    }
+
+    // set from the signal handler; polled from the message thread
+    static inline volatile std::sig_atomic_t quitRequested = 0;
+
+private:
+    static constexpr int signalPollMs = 250;
+    static constexpr int budgetCheckTicks = 20;   // every 5 s
+
+    Options options;
+    juce::AudioDeviceManager deviceManager;
+    juce::AudioProcessorPlayer player;
+    std::unique_ptr<juce::AudioProcessor> processor;
+    int ticks = 0;
+
+    juce::String pickDeviceType()
+    {
+        juce::String fallback;
+        for (auto* type : deviceManager.getAvailableDeviceTypes()) {
+            type->scanForDevices();
+            if (type->getDeviceNames (true).isEmpty()) {
+                continue;
+            }
+            if (type->getTypeName() == "JACK") {
+                return type->getTypeName();
+            }
+            if (fallback.isEmpty()) {
+                fallback = type->getTypeName();
+            }
+        }
+        return fallback;
+    }
+
+    void timerCallback() override
+    {
+        if (quitRequested != 0) {
+            stopTimer();
+            juce::JUCEApplicationBase::quit();
+            return;
+        }
+
+        if (++ticks % budgetCheckTicks == 0) {
+            checkCpuBudget();
+        }
+    }
+
+    void checkCpuBudget()
+    {
+        auto* device = deviceManager.getCurrentAudioDevice();
+        auto load = deviceManager.getCpuUsage();
+        if (device == nullptr || load <= options.cpuBudget) {
+            return;
+        }
+
+        auto current = device->getCurrentBufferSizeSamples();
+        for (auto size : device->getAvailableBufferSizes()) {
+            if (size > current) {
+                auto setup = deviceManager.getAudioDeviceSetup();
+                setup.bufferSize = size;
+                auto error = deviceManager.setAudioDeviceSetup (setup, true);
+                log ("CPU " + juce::String (load * 100.0, 2) + "% over budget, buffer " + juce::String (current) + " -> " + juce::String (size)
+                     + (error.isNotEmpty() ? " failed: " + error : juce::String()));
+                return;
+            }
+        }
+    }
+};
+
+//==============================================================================
+/**
+    The Standalone on Linux: JUCE's usual window around the editor, or with
+    --headless, the HeadlessMonitor and no GUI at all.
+*/
+class SignalbashStandaloneApp : public juce::JUCEApplication
+{
+public:
+    SignalbashStandaloneApp()
+    {
+        juce::PropertiesFile::Options options;
+        options.applicationName = juce::CharPointer_UTF8 (JucePlugin_Name);
+        options.filenameSuffix = ".settings";
+        options.folderName = "~/.config";
+        appProperties.setStorageParameters (options);
+    }
+
+    const juce::String getApplicationName() override              { return juce::CharPointer_UTF8 (JucePlugin_Name); }
+    const juce::String getApplicationVersion() override           { return JucePlugin_VersionString; }
+    bool moreThanOneInstanceAllowed() override                    { return true; }
+    void anotherInstanceStarted (const juce::String&) override    {}
+
+    void initialise (const juce::String& commandLine) override
+    {
+        juce::ArgumentList args (getApplicationName(), juce::StringArray::fromTokens (commandLine, true));
+
+        if (args.containsOption ("--help|-h")) {
+            printUsage();
+            setApplicationReturnValue (0);
+            quit();
+            return;
+        }
+
+        if (args.containsOption ("--list-devices")) {
+            HeadlessMonitor::listDevices();
+            quit();
+            return;
+        }
+
+        if (args.containsOption ("--headless")) {
+            std::signal (SIGINT, requestQuit);
+            std::signal (SIGTERM, requestQuit);
+
+            monitor = std::make_unique<HeadlessMonitor>();
+            auto error = monitor->start (HeadlessMonitor::Options::fromArguments (args));
+            if (error.isNotEmpty()) {
+                HeadlessMonitor::log ("Could not start: " + error);
+                monitor = nullptr;
+                setApplicationReturnValue (1);
+                quit();
+            }
+            return;
+        }
+
+        mainWindow = std::make_unique<juce::StandaloneFilterWindow> (getApplicationName(),
+                                                                     juce::LookAndFeel::getDefaultLookAndFeel().findColour (juce::ResizableWindow::backgroundColourId),
+                                                                     appProperties.getUserSettings(),
+                                                                     false);
+        mainWindow->setVisible (true);
+    }
+
+    void shutdown() override
+    {
+        monitor = nullptr;
+        mainWindow = nullptr;
+        appProperties.saveIfNeeded();
+    }
+
+    void systemRequestedQuit() override
+    {
+        if (mainWindow != nullptr) {
+            mainWindow->pluginHolder->savePluginState();
+        }
+
+        if (juce::ModalComponentManager::getInstance()->cancelAllModalComponents()) {
+            juce::Timer::callAfterDelay (100, [] {
+                if (auto* app = juce::JUCEApplicationBase::getInstance()) {
+                    app->systemRequestedQuit();
+                }
+            });
+        } else {
+            quit();
+        }
+    }
+
+private:
+    juce::ApplicationProperties appProperties;
+    std::unique_ptr<juce::StandaloneFilterWindow> mainWindow;
+    std::unique_ptr<HeadlessMonitor> monitor;
+
+    static void requestQuit (int)
+    {
+        HeadlessMonitor::quitRequested = 1;
+    }
+
+    static void printUsage()
+    {
+        std::cout << "Usage: Signalbash [--headless [options]] [--list-devices]\n"
+                  << "  --headless           track an audio input with no GUI\n"
+                  << "  --device-type=NAME   JACK or ALSA (default: JACK if it has inputs, else ALSA)\n"
+                  << "  --device=NAME        input device (default: the type's default)\n"
+                  << "  --channels=N         input channels to open (default 2)\n"
+                  << "  --sample-rate=HZ     default: the device's\n"
+                  << "  --buffer-size=N      samples per block (default 4096)\n"
+                  << "  --cpu-budget=PCT     grow the buffer while the callback uses more (default 1)\n"
+                  << "  --list-devices       print device types and their inputs\n";
+    }
+};
+
+juce::JUCEApplicationBase* juce_CreateApplication();
+juce::JUCEApplicationBase* juce_CreateApplication() { return new SignalbashStandaloneApp(); }
+
+#endif
@@ -0,0 +1,134 @@
+#include <cstring>
+
+#include "StatsExport.h"
+
+#if JUCE_LINUX
+ #include <fcntl.h>
+ #include <sys/mman.h>
+ #include <sys/stat.h>
+ #include <unistd.h>
+#endif
+
+static_assert (std::atomic<uint64_t>::is_always_lock_free, "stats export needs lock-free 64-bit atomics");
+
+//==============================================================================
+StatsExport::StatsExport() = default;
+
+StatsExport::~StatsExport()
+{
+   #if JUCE_LINUX
+    if (layout != nullptr) {
+        munmap (layout, sizeof (Layout));
+        shm_unlink (segmentName.c_str());
+    }
+   #endif
+}
+
+bool StatsExport::open (const std::string& host)
+{
+   #if JUCE_LINUX
+    segmentName = getSegmentPrefix (getuid()) + std::to_string (getpid());
+
+    // the name is per process, so anything already there was left by a dead process with our pid
+    shm_unlink (segmentName.c_str());
+    int fd = shm_open (segmentName.c_str(), O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+    if (fd < 0) {
+        return false;
+    }
+
+    if (ftruncate (fd, static_cast<off_t>(sizeof (Layout))) != 0) {
+        close (fd);
+        shm_unlink (segmentName.c_str());
+        return false;
+    }
+
+    auto* mapping = mmap (nullptr, sizeof (Layout), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close (fd);
+    if (mapping == MAP_FAILED) {
+        shm_unlink (segmentName.c_str());
+        return false;
+    }
+
+    // zero-filled by ftruncate, which is every record free
+    layout = static_cast<Layout*>(mapping);
+    layout->version = segmentVersion;
+    layout->recordSize = sizeof (Record);
+    layout->numRecords = maxInstances;
+    layout->pid = static_cast<int32_t>(getpid());
+    std::strncpy (layout->host, host.c_str(), hostBytes - 1);
+    layout->magic.store (segmentMagic, std::memory_order_release);
+
+    DBG("Stats export: " << segmentName);
+    return true;
+   #else
+    juce::ignoreUnused (host);
+    return false;
+   #endif
+}
+
+int StatsExport::claim (const std::string& host)
+{
+    const juce::ScopedLock scopedLock (lock);
+
+    if (layout == nullptr && !openFailed && !open (host)) {
+        DBG("Stats export unavailable");
+        openFailed = true;
+    }
+    if (layout == nullptr) {
+        return -1;
+    }
+
+    for (int slot = 0; slot < maxInstances; ++slot) {
+        if (!claimed[slot]) {
+            claimed[slot] = true;
+            Stats stats;
+            stats.instanceId = (static_cast<uint64_t>(layout->pid) << 32) | ++instanceCounter;
+            write (slot, stats);
+            return slot;
+        }
+    }
+
+    DBG("Stats export: no free record");
+    return -1;
+}
+
+void StatsExport::release (int slot)
+{
+    const juce::ScopedLock scopedLock (lock);
+
+    if (layout == nullptr || slot < 0 || slot >= maxInstances) {
+        return;
+    }
+
+    write (slot, {});
+    claimed[slot] = false;
+}
+
+void StatsExport::publish (int slot, const Stats& stats) noexcept
+{
+    if (layout == nullptr || slot < 0 || slot >= maxInstances) {
+        return;
+    }
+
+    auto withId = stats;
+    withId.instanceId = layout->records[slot].instanceId.load (std::memory_order_relaxed);
+    write (slot, withId);
+}
+
+void StatsExport::write (int slot, const Stats& stats) noexcept
+{
+    auto& record = layout->records[slot];
+    const auto sequence = record.sequence.load (std::memory_order_relaxed);
+    record.sequence.store (sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence (std::memory_order_release);
+
+    record.flags.store (stats.flags, std::memory_order_relaxed);
+    record.instanceId.store (stats.instanceId, std::memory_order_relaxed);
+    record.updatedMs.store (stats.updatedMs, std::memory_order_relaxed);
+    record.currentWindow.store (stats.currentWindow, std::memory_order_relaxed);
+    record.currentWindowMs.store (stats.currentWindowMs, std::memory_order_relaxed);
+    record.pendingWindows.store (stats.pendingWindows, std::memory_order_relaxed);
+    record.pendingMs.store (stats.pendingMs, std::memory_order_relaxed);
+
+    record.sequence.store (sequence + 2, std::memory_order_release);
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Read-only export of every instance's live state for local dashboards and
+    tools (see tools/stats).
+
+    Each process hosting Signalbash maps one POSIX shared-memory object,
+    /signalbash-stats-v<version>-<uid>-<pid>. It holds a header (magic,
+    version, record size, pid, host) and one Record per instance. An instance
+    owns its record and is its only writer. It publishes from its timer with
+    plain atomic stores: no syscalls, no locks. Readers map the object
+    read-only and take snapshots under a seqlock. The sequence is odd while a
+    write is in progress, and a snapshot only counts if it saw the same even
+    sequence before and after.
+
+    Linux only. Elsewhere claim() returns -1 and nothing is published. Hold it
+    through a juce::SharedResourcePointer.
+*/
+class StatsExport
+{
+public:
+    static constexpr uint32_t segmentMagic = 0x54534253; // "SBST"
+    static constexpr uint32_t segmentVersion = 1;
+    static constexpr int maxInstances = 64;
+    static constexpr int hostBytes = 64;
+
+    enum Flags : uint32_t
+    {
+        signalHot           = 1 << 0,
+        connectionHealthy   = 1 << 1,
+        sessionKeyValidated = 1 << 2,
+        deepIdle            = 1 << 3,
+        leader              = 1 << 4    // submits for every instance on the machine
+    };
+
+    /** What an instance publishes and what a reader gets back. */
+    struct Stats
+    {
+        uint64_t instanceId = 0;        // 0: the record is free
+        int64_t updatedMs = 0;          // wall clock, ms since epoch
+        int64_t currentWindow = 0;      // start of the accounting window, s since epoch
+        int32_t currentWindowMs = 0;    // active time in it so far
+        int32_t pendingWindows = 0;     // closed windows not yet acknowledged by the API
+        int64_t pendingMs = 0;
+        uint32_t flags = 0;
+    };
+
+    /** The segment's layout. Every field is naturally aligned, so readers in
+        other languages can use fixed offsets; records are recordSize apart.
+    */
+    struct alignas (64) Record
+    {
+        std::atomic<uint32_t> sequence;
+        std::atomic<uint32_t> flags;
+        std::atomic<uint64_t> instanceId;
+        std::atomic<int64_t> updatedMs;
+        std::atomic<int64_t> currentWindow;
+        std::atomic<int32_t> currentWindowMs;
+        std::atomic<int32_t> pendingWindows;
+        std::atomic<int64_t> pendingMs;
+    };
+
+    struct Layout
+    {
+        std::atomic<uint32_t> magic;    // stored last, with release, once the header is complete
+        uint32_t version;
+        uint32_t recordSize;
+        uint32_t numRecords;
+        int32_t pid;
+        char host[hostBytes];           // NUL-terminated
+        Record records[maxInstances];
+    };
+
+    StatsExport();
+    ~StatsExport();
+
+    /** Claims a record for one instance, creating the segment on first use.
+        Returns -1 if the segment is unavailable or full.
+    */
+    int claim (const std::string& host);
+    void release (int slot);
+
+    /** Writes the slot's record, keeping the instanceId it got from claim().
+        Only the instance that claimed the slot may call this.
+    */
+    void publish (int slot, const Stats& stats) noexcept;
+
+    /** Reader side: a consistent copy of a claimed record. Returns false if the
+        record is free or kept changing under the reader.
+    */
+    static bool read (const Record& record, Stats& stats) noexcept
+    {
+        for (int attempt = 0; attempt < 64; ++attempt) {
+            const auto before = record.sequence.load (std::memory_order_acquire);
+            if ((before & 1) != 0) {
+                continue;
+            }
+
+            stats.flags = record.flags.load (std::memory_order_relaxed);
+            stats.instanceId = record.instanceId.load (std::memory_order_relaxed);
+            stats.updatedMs = record.updatedMs.load (std::memory_order_relaxed);
+            stats.currentWindow = record.currentWindow.load (std::memory_order_relaxed);
+            stats.currentWindowMs = record.currentWindowMs.load (std::memory_order_relaxed);
+            stats.pendingWindows = record.pendingWindows.load (std::memory_order_relaxed);
+            stats.pendingMs = record.pendingMs.load (std::memory_order_relaxed);
+
+            std::atomic_thread_fence (std::memory_order_acquire);
+            if (record.sequence.load (std::memory_order_relaxed) == before) {
+                return stats.instanceId != 0;
+            }
+        }
+        return false;
+    }
+
+    /** Object names are this prefix followed by the pid, e.g. for a reader to shm_open. */
+    static std::string getSegmentPrefix (uint32_t uid)
+    {
+        return "/signalbash-stats-v" + std::to_string (segmentVersion) + "-" + std::to_string (uid) + "-";
+    }
+
+private:
+    juce::CriticalSection lock;
+    Layout* layout = nullptr;
+    bool openFailed = false;
+    std::string segmentName;
+    bool claimed[maxInstances] = {};
+    uint32_t instanceCounter = 0;
+
+    bool open (const std::string& host);
+    void write (int slot, const Stats& stats) noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StatsExport)
+};
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Decides when an instance submits its backlog. Polled from the message
+    thread; holds no locks and does no I/O.
+
+    Submissions fall on a grid of the base interval, offset by a fixed per-install
+    phase. Every install therefore hits the server at its own point within the
+    interval, spreading the fleet evenly without random sleeps. When the time
+    submitted per interval is sparse, the interval doubles up to maxStretch times
+    the base. Any real density of activity resets it to the base interval.
+
+    Some cases submit on the next poll rather than waiting for the grid:
+    - the backlog reaches backlogThresholdWindows (at most once per minBacklogSpacingMs).
+    - the session ends, i.e. the signal has been silent for sessionEndSilenceMs
+      after activity, or the host released the processor.
+*/
+class SubmissionScheduler
+{
+public:
+    enum class Reason
+    {
+        none,
+        interval,
+        backlog,
+        sessionEnd
+    };
+
+    SubmissionScheduler(int baseIntervalSecondsToUse)
+        : baseIntervalMs(static_cast<int64_t>(baseIntervalSecondsToUse) * 1000)
+    {
+    }
+
+    /** Fixed offset of this install within each interval, in [0, baseInterval). */
+    void setPhaseMs(int64_t newPhaseMs)
+    {
+        phaseMs = ((newPhaseMs % baseIntervalMs) + baseIntervalMs) % baseIntervalMs;
+        nextDueMs = 0;
+    }
+
+    /** Forgets the schedule, e.g. after the wall clock stepped. */
+    void reset() { nextDueMs = 0; }
+
+    /** lastSignalMs is the wall time of the last active audio block (0 if none yet). */
+    Reason poll(int64_t nowMs, int64_t lastSignalMs, int pendingWindows, bool sessionEnded)
+    {
+        if (nextDueMs == 0) {
+            lastSubmissionMs = nowMs;
+            nextDueMs = nextGridPoint(nowMs);
+        }
+
+        if (pendingWindows == 0) {
+            return Reason::none;
+        }
+
+        if (sessionEnded || (lastSignalMs > lastSubmissionMs && nowMs - lastSignalMs >= sessionEndSilenceMs)) {
+            return Reason::sessionEnd;
+        }
+
+        if (pendingWindows >= backlogThresholdWindows && nowMs - lastSubmissionMs >= minBacklogSpacingMs) {
+            return Reason::backlog;
+        }
+
+        return nowMs >= nextDueMs ? Reason::interval : Reason::none;
+    }
+
+    /** Call when a submission was dispatched, with the activity it carries. */
+    void submitted(int64_t nowMs, int64_t pendingMilliseconds)
+    {
+        auto elapsedMs = juce::jmax<int64_t>(1, nowMs - lastSubmissionMs);
+        auto density = static_cast<double>(pendingMilliseconds) / static_cast<double>(elapsedMs);
+
+        stretch = density < sparseDensity ? juce::jmin(stretch * 2, maxStretch) : 1;
+
+        lastSubmissionMs = nowMs;
+        nextDueMs = nextGridPoint(nowMs);
+    }
+
+    int getIntervalSeconds() const { return static_cast<int>(baseIntervalMs * stretch / 1000); }
+
+    /** 0-100 progress towards the next scheduled submission. */
+    double getProgress(int64_t nowMs) const
+    {
+        if (nextDueMs == 0) return 0.0;
+        auto intervalMs = static_cast<double>(baseIntervalMs * stretch);
+        return juce::jlimit(0.0, 100.0, 100.0 * (1.0 - static_cast<double>(nextDueMs - nowMs) / intervalMs));
+    }
+
+    static constexpr int maxStretch = 8;
+    static constexpr int backlogThresholdWindows = 30;
+    static constexpr int64_t minBacklogSpacingMs = 10 * 1000;
+    static constexpr int64_t sessionEndSilenceMs = 30 * 1000;
+    static constexpr double sparseDensity = 0.1;
+
+private:
+    int64_t baseIntervalMs;
+    int64_t phaseMs = 0;
+    int stretch = 1;
+    int64_t lastSubmissionMs = 0;
+    int64_t nextDueMs = 0;
+
+    int64_t nextGridPoint(int64_t nowMs) const
+    {
+        auto intervalMs = baseIntervalMs * stretch;
+        auto slot = (nowMs - phaseMs) / intervalMs + 1;
+        return slot * intervalMs + phaseMs;
+    }
+};
@@ -0,0 +1,233 @@
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "Tracer.h"
+
+std::atomic<bool> Tracer::enabled { false };
+
+namespace
+{
+    struct Event
+    {
+        std::atomic<const char*> category { nullptr };
+        std::atomic<const char*> name { nullptr };
+        std::atomic<int64_t> startMicros { 0 };
+        std::atomic<int64_t> durationMicros { 0 };  // negative for instant events
+    };
+
+    struct ThreadBuffer
+    {
+        std::unique_ptr<Event[]> events { new Event[(size_t) Tracer::eventsPerThread] };
+        std::atomic<uint64_t> written { 0 };
+        std::atomic<const char*> explicitName { nullptr };
+        std::atomic<bool> ready { false };
+        char threadName[64] = {};
+    };
+
+    struct Registry
+    {
+        std::array<std::unique_ptr<ThreadBuffer>, Tracer::maxThreads> buffers;
+        std::atomic<int> claimed { 0 };
+        std::atomic<bool> allocated { false };
+        juce::CriticalSection lock;
+    };
+
+    Registry& getRegistry()
+    {
+        static Registry registry;
+        return registry;
+    }
+
+    thread_local ThreadBuffer* currentBuffer = nullptr;
+    thread_local bool outOfBuffers = false;
+
+    // first event on a thread: claim the next preallocated buffer, no allocation here
+    ThreadBuffer* getBufferForCurrentThread() noexcept
+    {
+        if (currentBuffer != nullptr || outOfBuffers) {
+            return currentBuffer;
+        }
+
+        auto& registry = getRegistry();
+        if (!registry.allocated.load (std::memory_order_acquire)) {
+            return nullptr;
+        }
+
+        auto index = registry.claimed.fetch_add (1, std::memory_order_acq_rel);
+        if (index >= Tracer::maxThreads) {
+            outOfBuffers = true;
+            return nullptr;
+        }
+
+        // this can be a host's audio thread: name it without building a juce::String
+        // (the thread's own name is shared, not copied)
+        auto* buffer = registry.buffers[(size_t) index].get();
+        if (auto* thread = juce::Thread::getCurrentThread()) {
+            thread->getThreadName().copyToUTF8 (buffer->threadName, sizeof (buffer->threadName));
+        } else if (auto* mm = juce::MessageManager::getInstanceWithoutCreating(); mm != nullptr && mm->isThisTheMessageThread()) {
+            std::strncpy (buffer->threadName, "Message", sizeof (buffer->threadName) - 1);
+        } else {
+            std::snprintf (buffer->threadName, sizeof (buffer->threadName), "Thread %d", index);
+        }
+        buffer->ready.store (true, std::memory_order_release);
+
+        currentBuffer = buffer;
+        return buffer;
+    }
+
+    struct ExportedEvent
+    {
+        const char* category;
+        const char* name;
+        int64_t startMicros;
+        int64_t durationMicros;
+    };
+}
+
+//==============================================================================
+void Tracer::setEnabled (bool shouldBeEnabled)
+{
+   #if SIGNALBASH_TRACING
+    auto& registry = getRegistry();
+
+    if (shouldBeEnabled && !registry.allocated.load (std::memory_order_acquire)) {
+        const juce::ScopedLock sl (registry.lock);
+        for (auto& buffer : registry.buffers) {
+            buffer = std::make_unique<ThreadBuffer>();
+        }
+        registry.allocated.store (true, std::memory_order_release);
+    }
+
+    enabled.store (shouldBeEnabled, std::memory_order_release);
+    DBG("Tracing " << (shouldBeEnabled ? "enabled" : "disabled"));
+   #else
+    juce::ignoreUnused (shouldBeEnabled);
+   #endif
+}
+
+int64_t Tracer::nowMicros() noexcept
+{
+    static const double ticksToMicros = 1.0e6 / static_cast<double> (juce::Time::getHighResolutionTicksPerSecond());
+    return static_cast<int64_t> (static_cast<double> (juce::Time::getHighResolutionTicks()) * ticksToMicros);
+}
+
+void Tracer::record (const char* category, const char* name, int64_t startMicros, int64_t durationMicros) noexcept
+{
+    auto* buffer = getBufferForCurrentThread();
+    if (buffer == nullptr) {
+        return;
+    }
+
+    // single writer per buffer; the exporter discards slots overwritten while it reads
+    auto index = buffer->written.load (std::memory_order_relaxed);
+    auto& event = buffer->events[(size_t) (index % (uint64_t) eventsPerThread)];
+    event.category.store (category, std::memory_order_relaxed);
+    event.name.store (name, std::memory_order_relaxed);
+    event.startMicros.store (startMicros, std::memory_order_relaxed);
+    event.durationMicros.store (durationMicros, std::memory_order_relaxed);
+    buffer->written.store (index + 1, std::memory_order_release);
+}
+
+void Tracer::nameCurrentThread (const char* name) noexcept
+{
+    if (!isEnabled()) {
+        return;
+    }
+
+    if (auto* buffer = getBufferForCurrentThread()) {
+        if (buffer->explicitName.load (std::memory_order_relaxed) != name) {
+            buffer->explicitName.store (name, std::memory_order_relaxed);
+        }
+    }
+}
+
+//==============================================================================
+juce::Result Tracer::exportChromeJSON (const juce::File& file)
+{
+    auto& registry = getRegistry();
+    if (!registry.allocated.load (std::memory_order_acquire)) {
+        return juce::Result::fail ("Tracing has not been enabled");
+    }
+
+    juce::MemoryOutputStream json;
+    json << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+    bool first = true;
+    auto separator = [&json, &first] {
+        if (!first) json << ",\n";
+        first = false;
+    };
+
+    std::vector<ExportedEvent> events;
+    events.reserve ((size_t) eventsPerThread);
+
+    auto numBuffers = juce::jmin (registry.claimed.load (std::memory_order_acquire), maxThreads);
+    for (int tid = 0; tid < numBuffers; ++tid) {
+        auto& buffer = *registry.buffers[(size_t) tid];
+        if (!buffer.ready.load (std::memory_order_acquire)) {
+            continue;
+        }
+
+        events.clear();
+        auto end = buffer.written.load (std::memory_order_acquire);
+        auto begin = end > (uint64_t) eventsPerThread ? end - (uint64_t) eventsPerThread : 0;
+
+        for (auto i = begin; i < end; ++i) {
+            auto& event = buffer.events[(size_t) (i % (uint64_t) eventsPerThread)];
+            events.push_back ({ event.category.load (std::memory_order_relaxed),
+                                event.name.load (std::memory_order_relaxed),
+                                event.startMicros.load (std::memory_order_relaxed),
+                                event.durationMicros.load (std::memory_order_relaxed) });
+        }
+
+        // anything the writer lapped while we copied may be torn
+        auto endAfter = buffer.written.load (std::memory_order_acquire);
+        auto firstIntact = endAfter > (uint64_t) eventsPerThread ? endAfter - (uint64_t) eventsPerThread : 0;
+        auto skip = firstIntact > begin ? juce::jmin ((size_t) (firstIntact - begin), events.size()) : (size_t) 0;
+
+        auto* explicitName = buffer.explicitName.load (std::memory_order_relaxed);
+        juce::String threadName = explicitName != nullptr ? juce::String (explicitName) : juce::String (buffer.threadName);
+
+        separator();
+        json << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+             << ",\"args\":{\"name\":" << juce::JSON::toString (threadName) << "}}";
+
+        for (auto i = skip; i < events.size(); ++i) {
+            const auto& event = events[i];
+            if (event.name == nullptr) {
+                continue;
+            }
+
+            separator();
+            json << "{\"name\":\"" << event.name << "\",\"cat\":\"" << event.category
+                 << "\",\"pid\":1,\"tid\":" << tid
+                 << ",\"ts\":" << (juce::int64) event.startMicros;
+
+            if (event.durationMicros < 0) {
+                json << ",\"ph\":\"i\",\"s\":\"t\"}";
+            } else {
+                json << ",\"ph\":\"X\",\"dur\":" << (juce::int64) event.durationMicros << "}";
+            }
+        }
+    }
+
+    json << "]}\n";
+
+    file.getParentDirectory().createDirectory();
+    if (!file.replaceWithData (json.getData(), json.getDataSize())) {
+        return juce::Result::fail ("Could not write " + file.getFullPathName());
+    }
+
+    DBG("Trace exported to " << file.getFullPathName());
+    return juce::Result::ok();
+}
+
+juce::File Tracer::getDefaultExportFile()
+{
+    return juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory)
+        .getChildFile ("Signalbash")
+        .getChildFile ("traces")
+        .getChildFile ("signalbash-trace-" + juce::Time::getCurrentTime().formatted ("%Y%m%d-%H%M%S") + ".json");
+}
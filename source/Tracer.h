@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <JuceHeader.h>
+
+#ifndef SIGNALBASH_TRACING
+ #define SIGNALBASH_TRACING 1
+#endif
+
+//==============================================================================
+/**
+    Opt-in event tracing for diagnosing stalls across the audio, message and
+    worker threads.
+
+    Each thread writes into its own fixed-size ring of events, claimed the first
+    time it records while tracing is on. Recording is a relaxed flag check when
+    tracing is off, and a handful of relaxed stores when it is on: no locks and
+    no allocation. The buffers are allocated when tracing is first enabled and
+    keep the most recent eventsPerThread events of each thread.
+
+    exportChromeJSON() writes the Chrome Trace Event format, which both
+    chrome://tracing and ui.perfetto.dev open directly.
+
+    Event names and categories must be string literals (only the pointer is kept).
+    Build with SIGNALBASH_TRACING=0 to compile every trace point out.
+*/
+class Tracer
+{
+public:
+    static bool isEnabled() noexcept
+    {
+       #if SIGNALBASH_TRACING
+        return enabled.load (std::memory_order_relaxed);
+       #else
+        return false;
+       #endif
+    }
+
+    /** Turns recording on or off. Call from the message thread. */
+    static void setEnabled (bool shouldBeEnabled);
+
+    static int64_t nowMicros() noexcept;
+
+    /** Records a span that started at startMicros and ends now. */
+    static void complete (const char* category, const char* name, int64_t startMicros) noexcept
+    {
+        if (isEnabled()) record (category, name, startMicros, juce::jmax<int64_t> (0, nowMicros() - startMicros));
+    }
+
+    static void complete (const char* category, const char* name, int64_t startMicros, int64_t endMicros) noexcept
+    {
+        if (isEnabled()) record (category, name, startMicros, juce::jmax<int64_t> (0, endMicros - startMicros));
+    }
+
+    static void instant (const char* category, const char* name) noexcept
+    {
+        if (isEnabled()) record (category, name, nowMicros(), -1);
+    }
+
+    /** Labels the calling thread in exported traces (e.g. the host's audio thread). */
+    static void nameCurrentThread (const char* name) noexcept;
+
+    /** Writes every buffered event as Chrome Trace Event JSON. */
+    static juce::Result exportChromeJSON (const juce::File& file);
+
+    /** A new timestamped file under the user's app data folder. */
+    static juce::File getDefaultExportFile();
+
+    /** Records the lifetime of the enclosing scope as one span. */
+    class Scope
+    {
+    public:
+        Scope (const char* categoryToUse, const char* nameToUse) noexcept
+            : category (categoryToUse), name (nameToUse), startMicros (isEnabled() ? nowMicros() : -1)
+        {
+        }
+
+        ~Scope()
+        {
+            if (startMicros >= 0) complete (category, name, startMicros);
+        }
+
+    private:
+        const char* category;
+        const char* name;
+        int64_t startMicros;
+
+        JUCE_DECLARE_NON_COPYABLE (Scope)
+    };
+
+    static constexpr int maxThreads = 32;
+    static constexpr int eventsPerThread = 8192;
+
+private:
+    static std::atomic<bool> enabled;
+
+    static void record (const char* category, const char* name, int64_t startMicros, int64_t durationMicros) noexcept;
+};
+
+#if SIGNALBASH_TRACING
+ #define SIGNALBASH_TRACE_SCOPE(category, name) const Tracer::Scope JUCE_JOIN_MACRO (traceScope_, __LINE__) (category, name)
+ #define SIGNALBASH_TRACE_INSTANT(category, name) Tracer::instant (category, name)
+ #define SIGNALBASH_TRACE_THREAD_NAME(name) Tracer::nameCurrentThread (name)
+#else
+ #define SIGNALBASH_TRACE_SCOPE(category, name)
+ #define SIGNALBASH_TRACE_INSTANT(category, name)
+ #define SIGNALBASH_TRACE_THREAD_NAME(name)
+#endif
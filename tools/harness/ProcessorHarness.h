@@ -0,0 +1,207 @@
+/*
+  ==============================================================================
+
+    ProcessorHarness.h
+
+    Runs real SignalbashAudioProcessor instances inside a developer tool:
+
+    - ScratchEnvironment points everything the processors persist (settings,
+      history, key cache, inter-process locks) at a scratch HOME, gives them a
+      shared activity segment of their own, and optionally puts the
+      ClockService on an accelerated virtual clock.
+    - AudioDriver calls processBlock for every instance from a few audio
+      threads, paced by that clock, with a signal pattern the tool chooses.
+    - the tool's main thread is the message thread; runMessageLoop() lets the
+      processors' timers, async updates and change messages run.
+
+    Linux only: it relies on HOME for the data directory and on shm_unlink.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <JuceHeader.h>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "ClockService.h"
+#include "PluginProcessor.h"
+#include "SharedActivitySegment.h"
+
+namespace ProcessorHarness
+{
+    //==============================================================================
+    /** Create first thing in main(), before JUCE is initialised or any processor exists. */
+    class ScratchEnvironment
+    {
+    public:
+        ScratchEnvironment (const juce::String& toolName, double clockSpeed)
+        {
+            home = juce::File::getSpecialLocation (juce::File::tempDirectory)
+                       .getNonexistentChildFile (toolName + "-" + juce::String (getpid()), {}, false);
+            home.createDirectory();
+            setenv ("HOME", home.getFullPathName().toRawUTF8(), 1);
+
+            segmentName = "/" + toolName.toStdString() + "-" + std::to_string (getpid());
+            SharedActivitySegment::useSegmentName (segmentName);
+
+            if (clockSpeed != 1.0)
+                ClockService::useVirtualTime (juce::Time::currentTimeMillis(), clockSpeed);
+        }
+
+        ~ScratchEnvironment()
+        {
+            shm_unlink (segmentName.c_str());
+            home.deleteRecursively();
+        }
+
+        /** Writes signalbash_config.settings, which every processor created afterwards reads. */
+        void writeSettings (const juce::StringPairArray& values) const
+        {
+            juce::PropertiesFile::Options options;
+            options.applicationName     = "signalbash_config";
+            options.filenameSuffix      = "settings";
+            options.folderName          = "Signalbash";
+
+            auto file = juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory)
+                            .getChildFile (options.folderName)
+                            .getChildFile (options.applicationName + "." + options.filenameSuffix);
+
+            juce::PropertiesFile settings (file, options);
+            for (auto& key : values.getAllKeys())
+                settings.setValue (key, values[key]);
+            settings.saveIfNeeded();
+        }
+
+        const std::string& getSegmentName() const { return segmentName; }
+
+    private:
+        juce::File home;
+        std::string segmentName;
+
+        JUCE_DECLARE_NON_COPYABLE (ScratchEnvironment)
+    };
+
+    //==============================================================================
+    /** A processor prepared the way a host would. Call on the message thread. */
+    inline std::unique_ptr<SignalbashAudioProcessor> createProcessor (double sampleRate, int blockSize)
+    {
+        auto processor = std::make_unique<SignalbashAudioProcessor>();
+        processor->setRateAndBufferSizeDetails (sampleRate, blockSize);
+        processor->prepareToPlay (sampleRate, blockSize);
+        return processor;
+    }
+
+    /** Runs the message loop (timers, async updates, change messages) for a while of real time. */
+    inline void runMessageLoop (int milliseconds)
+    {
+        juce::MessageManager::getInstance()->runDispatchLoopUntil (milliseconds);
+    }
+
+    /** Resident set size of this process, in bytes. */
+    inline int64_t residentBytes()
+    {
+        std::ifstream statm ("/proc/self/statm");
+        int64_t pages = 0, residentPages = 0;
+        statm >> pages >> residentPages;
+        return residentPages * sysconf (_SC_PAGESIZE);
+    }
+
+    //==============================================================================
+    /** Drives processBlock for a set of instances from a few audio threads, one
+        block per instance every blockSize samples of the ClockService's time.
+
+        The pattern decides, per instance and block, whether the block carries
+        signal; observer (optional) is told about every block after it has been
+        processed, from the audio thread that processed it.
+    */
+    class AudioDriver
+    {
+    public:
+        using Pattern = std::function<bool (int instance, int64_t nowMs)>;
+        using Observer = std::function<void (int instance, int64_t nowMs, double blockMs, bool active)>;
+
+        AudioDriver (std::vector<SignalbashAudioProcessor*> processorsToDrive, int numThreads,
+                     double sampleRateToUse, int blockSizeToUse, Pattern patternToUse, Observer observerToUse = {})
+            : processors (std::move (processorsToDrive)), sampleRate (sampleRateToUse), blockSize (blockSizeToUse),
+              pattern (std::move (patternToUse)), observer (std::move (observerToUse))
+        {
+            for (int t = 0; t < juce::jmax (1, numThreads); ++t)
+                threads.emplace_back ([this, t, numThreads] { run (t, juce::jmax (1, numThreads)); });
+        }
+
+        ~AudioDriver() { stop(); }
+
+        void stop()
+        {
+            running.store (false);
+            for (auto& thread : threads)
+                if (thread.joinable())
+                    thread.join();
+        }
+
+        /** Blocks processed more than one block late, i.e. the threads couldn't keep up with the clock. */
+        int64_t getLateBlocks() const { return lateBlocks.load(); }
+        int64_t getBlocksProcessed() const { return blocksProcessed.load(); }
+
+    private:
+        std::vector<SignalbashAudioProcessor*> processors;
+        const double sampleRate;
+        const int blockSize;
+        Pattern pattern;
+        Observer observer;
+
+        juce::SharedResourcePointer<ClockService> clock;
+        std::atomic<bool> running { true };
+        std::atomic<int64_t> lateBlocks { 0 }, blocksProcessed { 0 };
+        std::vector<std::thread> threads;
+
+        void run (int threadIndex, int numThreads)
+        {
+            juce::AudioBuffer<float> buffer (2, blockSize);
+            juce::MidiBuffer midi;
+            const auto blockMs = blockSize * 1000.0 / sampleRate;
+            auto nextBlockMs = static_cast<double> (clock->nowMs());
+
+            while (running.load (std::memory_order_relaxed))
+            {
+                auto now = clock->nowMs();
+                if (static_cast<double> (now) < nextBlockMs)
+                {
+                    std::this_thread::sleep_for (std::chrono::microseconds (100));
+                    continue;
+                }
+
+                if (static_cast<double> (now) - nextBlockMs > blockMs)
+                    ++lateBlocks;
+
+                for (auto i = (size_t) threadIndex; i < processors.size(); i += (size_t) numThreads)
+                {
+                    const auto active = pattern ((int) i, now);
+                    for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+                        juce::FloatVectorOperations::fill (buffer.getWritePointer (channel), active ? 0.1f : 0.0f, blockSize);
+
+                    processors[i]->processBlock (buffer, midi);
+
+                    if (observer)
+                        observer ((int) i, now, blockMs, active);
+                }
+
+                blocksProcessed += (int64_t) ((processors.size() - (size_t) threadIndex + (size_t) numThreads - 1) / (size_t) numThreads);
+                nextBlockMs += blockMs;
+            }
+        }
+
+        JUCE_DECLARE_NON_COPYABLE (AudioDriver)
+    };
+}
@@ -0,0 +1,184 @@
+/*
+  ==============================================================================
+
+    LoadTest.cpp
+
+    Runs N real processors headless against the in-process mock API for a
+    number of simulated hours on an accelerated clock, and reports what they
+    cost the server and the machine: request throughput, submissions per
+    instance per simulated hour, retry amplification under injected 429s, 5xx
+    and disconnects, and resident memory sampled over the run, so a leak or a
+    backlog that grows with uptime shows up in minutes.
+
+    The instances share this process, and so one shared activity segment, like
+    the instances of one DAW session. Network backoff and Retry-After stay in
+    real time; only the accounting and scheduling clock is accelerated.
+
+  ==============================================================================
+*/
+
+#include <iomanip>
+#include <iostream>
+#include <JuceHeader.h>
+
+#include "../harness/ProcessorHarness.h"
+#include "../mock_server/MockApiServer.h"
+
+struct LoadTestConfig
+{
+    int instances = 32;
+    int audioThreads = 4;
+    double hours = 4.0;
+    double speed = 60.0;
+    double sampleRate = 48000.0;
+    int blockSize = 512;
+    double duty = 0.5;
+    int reportMinutes = 30;
+    MockServerConfig server;
+
+    static LoadTestConfig fromArguments (const juce::ArgumentList& args)
+    {
+        LoadTestConfig config;
+        auto intArg    = [&args] (const char* name, int fallback)    { return args.containsOption (name) ? args.getValueForOption (name).getIntValue() : fallback; };
+        auto doubleArg = [&args] (const char* name, double fallback) { return args.containsOption (name) ? args.getValueForOption (name).getDoubleValue() : fallback; };
+
+        config.instances     = juce::jmax (1, intArg ("--instances", config.instances));
+        config.audioThreads  = juce::jmax (1, intArg ("--audio-threads", config.audioThreads));
+        config.hours         = juce::jmax (0.1, doubleArg ("--hours", config.hours));
+        config.speed         = juce::jlimit (1.0, 600.0, doubleArg ("--speed", config.speed));
+        config.sampleRate    = doubleArg ("--sample-rate", config.sampleRate);
+        config.blockSize     = juce::jmax (16, intArg ("--block-size", config.blockSize));
+        config.duty          = juce::jlimit (0.0, 1.0, doubleArg ("--duty", config.duty));
+        config.reportMinutes = juce::jmax (1, intArg ("--report-minutes", config.reportMinutes));
+
+        // a port of its own, so a mock server left running on 7575 doesn't get in the way
+        config.server = MockServerConfig::fromArguments (args);
+        if (! args.containsOption ("--port"))
+            config.server.port = 7576;
+        return config;
+    }
+};
+
+//==============================================================================
+/** Each instance plays for `duty` of every ten simulated minutes, offset so the instances don't all start together. */
+static bool isPlaying (const LoadTestConfig& config, int instance, int64_t nowMs)
+{
+    constexpr int64_t periodMs = 10 * 60 * 1000;
+    const auto phase = periodMs * instance / config.instances;
+    return (double) ((nowMs + phase) % periodMs) < config.duty * (double) periodMs;
+}
+
+static double toMegabytes (int64_t bytes)
+{
+    return (double) bytes / (1024.0 * 1024.0);
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ArgumentList args (argc, argv);
+
+    if (args.containsOption ("--help|-h"))
+    {
+        std::cout << "Usage: " << args.executableName << " [options]\n"
+                  << "  --instances=N            processors to run (default 32)\n"
+                  << "  --audio-threads=N        threads calling processBlock (default 4)\n"
+                  << "  --hours=H                simulated hours to run (default 4)\n"
+                  << "  --speed=X                simulated seconds per real second (default 60)\n"
+                  << "  --sample-rate=R          (default 48000)\n"
+                  << "  --block-size=N           (default 512)\n"
+                  << "  --duty=P                 fraction of the time each instance has signal (default 0.5)\n"
+                  << "  --report-minutes=N       simulated minutes between report lines (default 30)\n"
+                  << "  --port=N, --latency-ms=N, --latency-jitter-ms=N, --rate-429=P, --rate-5xx=P,\n"
+                  << "  --rate-disconnect=P, --retry-after=N\n"
+                  << "                           as for signalbash-mock-server (port default 7576)\n";
+        return 0;
+    }
+
+    auto config = LoadTestConfig::fromArguments (args);
+    ProcessorHarness::ScratchEnvironment environment ("signalbash-load-test", config.speed);
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    MockApiServer server (config.server);
+    if (! server.start())
+    {
+        std::cerr << "Could not listen on 127.0.0.1:" << config.server.port << std::endl;
+        return 1;
+    }
+
+    juce::StringPairArray settings;
+    settings.set ("apiBase", "http://127.0.0.1:" + juce::String (config.server.port));
+    settings.set ("sessionKey", "load-test-session-key");
+    environment.writeSettings (settings);
+
+    juce::SharedResourcePointer<ClockService> clock;
+    const auto startMs = clock->nowMs();
+    const auto endMs = startMs + (int64_t) (config.hours * 60.0 * 60.0 * 1000.0);
+    const auto startRss = ProcessorHarness::residentBytes();
+
+    std::vector<std::unique_ptr<SignalbashAudioProcessor>> processors;
+    std::vector<SignalbashAudioProcessor*> driven;
+    for (int i = 0; i < config.instances; ++i)
+    {
+        processors.push_back (ProcessorHarness::createProcessor (config.sampleRate, config.blockSize));
+        driven.push_back (processors.back().get());
+    }
+
+    std::cout << "Running " << config.instances << " instances for " << config.hours << " simulated hours at "
+              << config.speed << "x against http://127.0.0.1:" << config.server.port << std::endl;
+
+    int64_t peakRss = ProcessorHarness::residentBytes();
+    {
+        ProcessorHarness::AudioDriver driver (driven, config.audioThreads, config.sampleRate, config.blockSize,
+                                              [&config] (int instance, int64_t nowMs) { return isPlaying (config, instance, nowMs); });
+
+        const auto reportEveryMs = (int64_t) config.reportMinutes * 60 * 1000;
+        auto nextReportMs = startMs + reportEveryMs;
+
+        while (clock->nowMs() < endMs)
+        {
+            ProcessorHarness::runMessageLoop (50);
+
+            auto now = clock->nowMs();
+            if (now < nextReportMs)
+                continue;
+
+            nextReportMs += reportEveryMs;
+            auto rss = ProcessorHarness::residentBytes();
+            peakRss = juce::jmax (peakRss, rss);
+
+            auto stats = server.getStats();
+            auto simulatedHours = (double) (now - startMs) / (60.0 * 60.0 * 1000.0);
+            std::cout << std::fixed << std::setprecision (2)
+                      << "t=" << simulatedHours << "h"
+                      << "  requests " << (int64_t) stats["requests"]
+                      << " (" << (double) stats["requests_per_second"] << "/s)"
+                      << "  submits/instance/h " << (double) (int64_t) stats["submit"] / config.instances / simulatedHours
+                      << "  amplification " << (double) stats["retry_amplification"]
+                      << "  rss " << toMegabytes (rss) << " MB" << std::endl;
+        }
+
+        driver.stop();
+        if (driver.getLateBlocks() > 0)
+            std::cout << "Audio threads fell behind on " << driver.getLateBlocks() << " of " << driver.getBlocksProcessed()
+                      << " blocks; lower --speed or --instances for faithful timing" << std::endl;
+    }
+
+    // the host stopping: each instance flushes what's pending, then give the requests time to land
+    for (auto* processor : driven)
+        processor->releaseResources();
+    ProcessorHarness::runMessageLoop (5000);
+
+    const auto endRss = ProcessorHarness::residentBytes();
+    processors.clear();
+
+    auto* summary = new juce::DynamicObject();
+    summary->setProperty ("instances", config.instances);
+    summary->setProperty ("simulated_hours", config.hours);
+    summary->setProperty ("server", server.getStats());
+    summary->setProperty ("rss_start_mb", toMegabytes (startRss));
+    summary->setProperty ("rss_peak_mb", toMegabytes (juce::jmax (peakRss, endRss)));
+    summary->setProperty ("rss_end_mb", toMegabytes (endRss));
+    std::cout << juce::JSON::toString (juce::var (summary), true) << std::endl;
+    return 0;
+}
@@ -0,0 +1,414 @@
+/*
+  ==============================================================================
+
+    MockApiServer.h
+
+    The mock Signalbash API behind signalbash-mock-server, in a header so the
+    load and stress tools can run it in-process next to the processors they
+    drive.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <random>
+#include <vector>
+#include <JuceHeader.h>
+
+struct MockServerConfig
+{
+    int port = 7575;
+    int latencyMs = 0;
+    int latencyJitterMs = 0;
+    double rate429 = 0.0;
+    double rate5xx = 0.0;
+    double rateDisconnect = 0.0;
+    int retryAfterSeconds = 5;
+    int reportSeconds = 10;
+
+    static MockServerConfig fromArguments (const juce::ArgumentList& args)
+    {
+        MockServerConfig config;
+        auto intArg    = [&args] (const char* name, int fallback)       { return args.containsOption (name) ? args.getValueForOption (name).getIntValue() : fallback; };
+        auto doubleArg = [&args] (const char* name, double fallback)    { return args.containsOption (name) ? args.getValueForOption (name).getDoubleValue() : fallback; };
+
+        config.port              = intArg    ("--port", config.port);
+        config.latencyMs         = intArg    ("--latency-ms", config.latencyMs);
+        config.latencyJitterMs   = intArg    ("--latency-jitter-ms", config.latencyJitterMs);
+        config.rate429           = doubleArg ("--rate-429", config.rate429);
+        config.rate5xx           = doubleArg ("--rate-5xx", config.rate5xx);
+        config.rateDisconnect    = doubleArg ("--rate-disconnect", config.rateDisconnect);
+        config.retryAfterSeconds = intArg    ("--retry-after", config.retryAfterSeconds);
+        config.reportSeconds     = intArg    ("--report-seconds", config.reportSeconds);
+        return config;
+    }
+};
+
+//==============================================================================
+struct HttpRequest
+{
+    juce::String method;
+    juce::String path;
+    juce::StringPairArray headers { false };
+    juce::String body;
+};
+
+struct HttpResponse
+{
+    int status = 200;
+    juce::StringPairArray headers;
+    juce::String body;
+    bool disconnect = false;
+};
+
+//==============================================================================
+class MockServerStats
+{
+public:
+    /** Activity credited to the server, one entry per window or bucket key accepted. */
+    struct AcceptedSpan
+    {
+        int64_t start = 0;          // seconds since epoch
+        int seconds = 0;
+        int milliseconds = 0;
+    };
+
+    static constexpr int windowSeconds = 10;
+
+    void recordRequest (const juce::String& path, int status)
+    {
+        ++totalRequests;
+        if (path == "/ping")                      ++pingRequests;
+        else if (path == "/submit")               ++submitRequests;
+        else if (path == "/validate-session-key") ++validateRequests;
+
+        if (status == 200)      ++status200;
+        else if (status == 429) ++status429;
+        else if (status >= 500) ++status5xx;
+        else if (status == 0)   ++disconnects;
+    }
+
+    /** Records an accepted /submit. Windows are credited once per idempotency
+        key, so a retried batch shows up as amplification rather than as extra
+        activity. An entry listed in activity_spans is a bucket of merged
+        windows, credited for its length under its own key, as the API does.
+    */
+    void recordSubmission (const juce::String& batchKey, const juce::var& activity, const juce::var& windowKeys, const juce::var& spans)
+    {
+        const std::lock_guard<std::mutex> lock (mutex);
+
+        if (batchKey.isNotEmpty())
+            ++batchKeys[batchKey];
+
+        if (auto* windows = activity.getDynamicObject())
+        {
+            for (const auto& window : windows->getProperties())
+            {
+                const auto seconds = juce::jmax (windowSeconds, static_cast<int> (spans.getProperty (window.name, windowSeconds)));
+
+                auto key = windowKeys.getProperty (window.name, juce::var()).toString();
+                if (key.isEmpty())
+                    key = window.name.toString() + "+" + juce::String (seconds) + "/" + juce::String (submitRequests.load());
+
+                if (windowsByKey.emplace (key, static_cast<int> (window.value)).second)
+                {
+                    acceptedMilliseconds += static_cast<int64_t> (window.value);
+                    acceptedSpans.push_back ({ window.name.toString().getLargeIntValue(), seconds, static_cast<int> (window.value) });
+                    if (seconds > windowSeconds)
+                        ++acceptedBuckets;
+                }
+                else
+                {
+                    ++duplicateWindows;
+                }
+            }
+        }
+    }
+
+    std::vector<AcceptedSpan> getAcceptedSpans() const
+    {
+        const std::lock_guard<std::mutex> lock (mutex);
+        return acceptedSpans;
+    }
+
+    juce::var toVar (double elapsedSeconds) const
+    {
+        const std::lock_guard<std::mutex> lock (mutex);
+
+        auto* obj = new juce::DynamicObject();
+        obj->setProperty ("elapsed_seconds", elapsedSeconds);
+        obj->setProperty ("requests", (juce::int64) totalRequests.load());
+        obj->setProperty ("requests_per_second", elapsedSeconds > 0.0 ? (double) totalRequests.load() / elapsedSeconds : 0.0);
+        obj->setProperty ("ping", (juce::int64) pingRequests.load());
+        obj->setProperty ("submit", (juce::int64) submitRequests.load());
+        obj->setProperty ("validate_session_key", (juce::int64) validateRequests.load());
+        obj->setProperty ("status_200", (juce::int64) status200.load());
+        obj->setProperty ("status_429", (juce::int64) status429.load());
+        obj->setProperty ("status_5xx", (juce::int64) status5xx.load());
+        obj->setProperty ("disconnects", (juce::int64) disconnects.load());
+        obj->setProperty ("unique_batches", (juce::int64) batchKeys.size());
+        obj->setProperty ("unique_windows", (juce::int64) windowsByKey.size());
+        obj->setProperty ("duplicate_windows", (juce::int64) duplicateWindows);
+        obj->setProperty ("accepted_buckets", (juce::int64) acceptedBuckets);
+        obj->setProperty ("accepted_ms", (juce::int64) acceptedMilliseconds);
+
+        // submit attempts per distinct batch; 1.0 means no retries reached the server
+        obj->setProperty ("retry_amplification", batchKeys.empty() ? 0.0
+                                                                   : (double) submitRequests.load() / (double) batchKeys.size());
+        return juce::var (obj);
+    }
+
+private:
+    std::atomic<int64_t> totalRequests { 0 }, pingRequests { 0 }, submitRequests { 0 }, validateRequests { 0 };
+    std::atomic<int64_t> status200 { 0 }, status429 { 0 }, status5xx { 0 }, disconnects { 0 };
+
+    mutable std::mutex mutex;
+    std::map<juce::String, int> batchKeys;
+    std::map<juce::String, int> windowsByKey;
+    std::vector<AcceptedSpan> acceptedSpans;
+    int64_t duplicateWindows = 0;
+    int64_t acceptedBuckets = 0;
+    int64_t acceptedMilliseconds = 0;
+};
+
+//==============================================================================
+class MockApiServer : public juce::Thread
+{
+public:
+    explicit MockApiServer (const MockServerConfig& c)
+        : juce::Thread ("MockApiServer"), config (c), connectionPool (8)
+    {
+    }
+
+    ~MockApiServer() override
+    {
+        listener.close();
+        stopThread (2000);
+        connectionPool.removeAllJobs (true, 2000);
+    }
+
+    bool start()
+    {
+        if (! listener.createListener (config.port, "127.0.0.1"))
+            return false;
+
+        startThread();
+        return true;
+    }
+
+    juce::var getStats() const
+    {
+        return stats.toVar ((juce::Time::getMillisecondCounterHiRes() - startedAt) / 1000.0);
+    }
+
+    std::vector<MockServerStats::AcceptedSpan> getAcceptedSpans() const { return stats.getAcceptedSpans(); }
+
+    /** Turns the configured latency, 429s, 5xx and disconnects on or off, e.g. so a backlog can drain at the end of a run. */
+    void setFaultInjection (bool enabled) { faultsEnabled.store (enabled); }
+
+    /** While set, every API request is disconnected, whatever the fault rates, as in a network outage. */
+    void setOutage (bool down) { outage.store (down); }
+
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            std::unique_ptr<juce::StreamingSocket> connection (listener.waitForNextConnection());
+            if (connection == nullptr)
+                continue;
+
+            auto* socket = connection.release();
+            connectionPool.addJob ([this, socket]
+            {
+                std::unique_ptr<juce::StreamingSocket> owned (socket);
+                handleConnection (*owned);
+            });
+        }
+    }
+
+private:
+    MockServerConfig config;
+    juce::StreamingSocket listener;
+    juce::ThreadPool connectionPool;
+    MockServerStats stats;
+    std::atomic<bool> faultsEnabled { true };
+    std::atomic<bool> outage { false };
+    const double startedAt = juce::Time::getMillisecondCounterHiRes();
+
+    std::mutex randomMutex;
+    std::mt19937 random { std::random_device{}() };
+
+    double nextUniform()
+    {
+        const std::lock_guard<std::mutex> lock (randomMutex);
+        return std::uniform_real_distribution<double> (0.0, 1.0) (random);
+    }
+
+    static bool readRequest (juce::StreamingSocket& socket, HttpRequest& request)
+    {
+        juce::MemoryBlock buffer;
+        char chunk[4096];
+        int headerEnd = -1;
+
+        while (headerEnd < 0)
+        {
+            if (socket.waitUntilReady (true, 5000) != 1)
+                return false;
+
+            auto numRead = socket.read (chunk, (int) sizeof (chunk), false);
+            if (numRead <= 0)
+                return false;
+
+            buffer.append (chunk, (size_t) numRead);
+            headerEnd = buffer.toString().indexOf ("\r\n\r\n");
+
+            if (buffer.getSize() > 64 * 1024)
+                return false;
+        }
+
+        auto raw = buffer.toString();
+        auto lines = juce::StringArray::fromLines (raw.substring (0, headerEnd));
+        auto requestLine = juce::StringArray::fromTokens (lines[0], " ", "");
+
+        request.method = requestLine[0];
+        request.path = requestLine[1].upToFirstOccurrenceOf ("?", false, false);
+
+        for (int i = 1; i < lines.size(); ++i)
+            request.headers.set (lines[i].upToFirstOccurrenceOf (":", false, false).trim(),
+                                 lines[i].fromFirstOccurrenceOf (":", false, false).trim());
+
+        auto contentLength = request.headers.getValue ("Content-Length", "0").getIntValue();
+        juce::MemoryBlock body (buffer.begin() + headerEnd + 4, buffer.getSize() - (size_t) headerEnd - 4);
+
+        while ((int) body.getSize() < contentLength)
+        {
+            if (socket.waitUntilReady (true, 5000) != 1)
+                return false;
+
+            auto numRead = socket.read (chunk, juce::jmin ((int) sizeof (chunk), contentLength - (int) body.getSize()), false);
+            if (numRead <= 0)
+                return false;
+
+            body.append (chunk, (size_t) numRead);
+        }
+
+        request.body = body.toString();
+        return true;
+    }
+
+    static void writeResponse (juce::StreamingSocket& socket, const HttpResponse& response)
+    {
+        auto reason = response.status == 200 ? "OK"
+                    : response.status == 404 ? "Not Found"
+                    : response.status == 429 ? "Too Many Requests"
+                    : response.status == 503 ? "Service Unavailable"
+                    : "Error";
+
+        juce::String head;
+        head << "HTTP/1.1 " << response.status << " " << reason << "\r\n"
+             << "Content-Type: application/json\r\n"
+             << "Content-Length: " << (int) response.body.getNumBytesAsUTF8() << "\r\n"
+             << "Connection: close\r\n";
+
+        for (auto& key : response.headers.getAllKeys())
+            head << key << ": " << response.headers[key] << "\r\n";
+
+        head << "\r\n" << response.body;
+        socket.write (head.toRawUTF8(), (int) head.getNumBytesAsUTF8());
+    }
+
+    HttpResponse route (const HttpRequest& request)
+    {
+        HttpResponse response;
+
+        if (request.path == "/stats")
+        {
+            response.body = juce::JSON::toString (getStats(), true);
+            return response;
+        }
+
+        if (request.path != "/ping" && request.path != "/submit" && request.path != "/validate-session-key")
+        {
+            response.status = 404;
+            response.body = "{\"error\":\"not found\"}";
+            return response;
+        }
+
+        if (outage.load())
+        {
+            response.disconnect = true;
+            return response;
+        }
+
+        auto roll = faultsEnabled.load() ? nextUniform() : 1.0;
+        if (roll < config.rateDisconnect)
+        {
+            response.disconnect = true;
+            return response;
+        }
+        roll -= config.rateDisconnect;
+
+        if (roll < config.rate429)
+        {
+            response.status = 429;
+            response.headers.set ("Retry-After", juce::String (config.retryAfterSeconds));
+            response.headers.set ("RateLimit-Remaining", "0");
+            response.headers.set ("RateLimit-Reset", juce::String (config.retryAfterSeconds));
+            response.body = "{\"error\":\"rate limited\"}";
+            return response;
+        }
+        roll -= config.rate429;
+
+        if (roll < config.rate5xx)
+        {
+            response.status = 503;
+            response.body = "{\"error\":\"unavailable\"}";
+            return response;
+        }
+
+        auto json = juce::JSON::parse (request.body);
+
+        if (request.path == "/validate-session-key")
+        {
+            auto key = json.getProperty ("session_key", juce::var()).toString();
+            response.status = key.startsWithIgnoreCase ("invalid") ? 404 : 200;
+        }
+        else if (request.path == "/submit")
+        {
+            stats.recordSubmission (request.headers.getValue ("Idempotency-Key", {}),
+                                    json.getProperty ("activity", juce::var()),
+                                    json.getProperty ("idempotency_keys", juce::var()),
+                                    json.getProperty ("activity_spans", juce::var()));
+        }
+
+        response.body = "{\"ok\":true}";
+        return response;
+    }
+
+    void handleConnection (juce::StreamingSocket& socket)
+    {
+        HttpRequest request;
+        if (! readRequest (socket, request))
+            return;
+
+        if (faultsEnabled.load() && (config.latencyMs > 0 || config.latencyJitterMs > 0))
+            juce::Thread::sleep (config.latencyMs + (int) (nextUniform() * config.latencyJitterMs));
+
+        auto response = route (request);
+
+        if (request.path != "/stats")
+            stats.recordRequest (request.path, response.disconnect ? 0 : response.status);
+
+        if (response.disconnect)
+        {
+            socket.close();
+            return;
+        }
+
+        writeResponse (socket, response);
+    }
+};
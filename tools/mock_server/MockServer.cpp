@@ -0,0 +1,80 @@
+/*
+  ==============================================================================
+
+    MockServer.cpp
+
+    Local stand-in for the Signalbash API, listening where debug builds point
+    `apiBase` (http://127.0.0.1:7575). Implements /ping, /submit and
+    /validate-session-key, with optional latency, 429/5xx and disconnect
+    injection, and keeps the counters needed to benchmark the plugin's
+    networking offline (GET /stats, or the periodic report on stdout).
+    SIGINT or SIGTERM stops it after printing the final stats.
+
+  ==============================================================================
+*/
+
+#include <atomic>
+#include <csignal>
+#include <iostream>
+#include "MockApiServer.h"
+
+//==============================================================================
+static std::atomic<bool> stopRequested { false };
+
+static void requestStop (int)
+{
+    stopRequested.store (true);
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ArgumentList args (argc, argv);
+
+    if (args.containsOption ("--help|-h"))
+    {
+        std::cout << "Usage: " << args.executableName << " [options]\n"
+                  << "  --port=N                 listen port (default 7575)\n"
+                  << "  --latency-ms=N           fixed delay before every response\n"
+                  << "  --latency-jitter-ms=N    extra random delay in [0, N)\n"
+                  << "  --rate-429=P             probability of a 429 with Retry-After\n"
+                  << "  --rate-5xx=P             probability of a 503\n"
+                  << "  --rate-disconnect=P      probability of closing without a response\n"
+                  << "  --retry-after=N          Retry-After seconds sent with 429s (default 5)\n"
+                  << "  --report-seconds=N       stats report interval, 0 to disable (default 10)\n";
+        return 0;
+    }
+
+    auto config = MockServerConfig::fromArguments (args);
+
+    MockApiServer server (config);
+    if (! server.start())
+    {
+        std::cerr << "Could not listen on 127.0.0.1:" << config.port << std::endl;
+        return 1;
+    }
+
+    std::cout << "Signalbash mock API listening on http://127.0.0.1:" << config.port << std::endl;
+
+    std::signal (SIGINT, requestStop);
+    std::signal (SIGTERM, requestStop);
+
+    // sleep in short steps so Ctrl-C (or a harness's SIGTERM) is answered promptly
+    const auto reportIntervalMs = config.reportSeconds * 1000;
+    auto sinceReportMs = 0;
+
+    while (! stopRequested.load())
+    {
+        juce::Thread::sleep (100);
+        sinceReportMs += 100;
+
+        if (reportIntervalMs > 0 && sinceReportMs >= reportIntervalMs)
+        {
+            sinceReportMs = 0;
+            std::cout << juce::JSON::toString (server.getStats(), true) << std::endl;
+        }
+    }
+
+    std::cout << "Final stats:\n" << juce::JSON::toString (server.getStats(), true) << std::endl;
+    return 0;
+}
@@ -0,0 +1,444 @@
+/*
+  ==============================================================================
+
+    Replay.cpp
+
+    Feeds envelope captures (.sbenv, recorded with CAPTURE in the debug
+    settings view) through ActivityAccountant under a virtual clock, as
+    captured and re-blocked to a matrix of sample rates and buffer sizes, and
+    diffs each resulting window map against a golden file next to the
+    capture. Hours of session replay in a fraction of a second, so accounting
+    changes can be regression-tested without sitting in a DAW.
+
+    Like a lone instance with a session key, the accountant offers its time to
+    a SharedActivitySegment (a private one) and the replay harvests it window
+    by window, so the window maps are what the plugin would submit. The
+    captures under replay/captures are checked by the SignalbashReplayCheck
+    target.
+
+  ==============================================================================
+*/
+
+#include <iostream>
+#include <limits>
+#include <map>
+#include <string>
+#include <vector>
+#include <JuceHeader.h>
+
+#include "ActivityAccountant.h"
+#include "ActivityDetector.h"
+#include "EnvelopeCapture.h"
+#include "SharedActivitySegment.h"
+
+#if JUCE_LINUX
+ #include <sys/mman.h>
+ #include <unistd.h>
+#endif
+
+using WindowMap = std::map<int64_t, int>;
+
+struct ReplayConfig
+{
+    juce::StringArray captures;
+    std::vector<int> sampleRates { 44100, 48000, 96000 };
+    std::vector<int> blockSizes { 64, 256, 1024 };
+    bool writeGolden = false;
+    int toleranceMs = -1;
+
+    static std::vector<int> intList (const juce::String& text)
+    {
+        std::vector<int> values;
+        for (auto& token : juce::StringArray::fromTokens (text, ",", {}))
+            if (token.getIntValue() > 0)
+                values.push_back (token.getIntValue());
+        return values;
+    }
+
+    static ReplayConfig fromArguments (const juce::ArgumentList& args)
+    {
+        ReplayConfig config;
+
+        for (auto& argument : args.arguments)
+            if (! argument.isOption())
+                config.captures.add (argument.text);
+
+        if (args.containsOption ("--rates"))        config.sampleRates = intList (args.getValueForOption ("--rates"));
+        if (args.containsOption ("--block-sizes"))  config.blockSizes = intList (args.getValueForOption ("--block-sizes"));
+        if (args.containsOption ("--tolerance-ms")) config.toleranceMs = args.getValueForOption ("--tolerance-ms").getIntValue();
+        config.writeGolden = args.containsOption ("--write-golden");
+        return config;
+    }
+};
+
+//==============================================================================
+/** One processBlock call as the accountant sees it. */
+struct ReplayBlock
+{
+    int64_t nowMs;
+    int numSamples;
+    double sampleRate;
+    bool active;
+};
+
+// host scheduling jitter is dropped; anything longer is a real gap (transport stopped, plugin suspended)
+static constexpr double gapThresholdMs = 250.0;
+
+/** Blocks exactly as captured, on a clock that advances by each block's duration. */
+static std::vector<ReplayBlock> nativeBlocks (const std::vector<EnvelopeCapture::Record>& records, const ActivityDetector& detector)
+{
+    std::vector<ReplayBlock> blocks;
+    blocks.reserve (records.size());
+
+    double clockMs = records.empty() ? 0.0 : (double) records.front().nowMs;
+    for (const auto& record : records)
+    {
+        if ((double) record.nowMs > clockMs + gapThresholdMs)
+            clockMs = (double) record.nowMs;
+
+        bool active = false;
+        for (int channel = 0; channel < record.numChannels; ++channel)
+            active = active || detector.isChannelActive (record.sumOfSquares[channel], (int) record.numSamples);
+        auto midiActive = (record.flags & EnvelopeCapture::midiActive) != 0;
+        active = (active || midiActive) && (record.flags & EnvelopeCapture::bypassed) == 0;
+
+        blocks.push_back ({ (int64_t) clockMs, (int) record.numSamples, (double) record.sampleRate, active });
+
+        if (record.sampleRate > 0)
+            clockMs += record.numSamples * 1000.0 / record.sampleRate;
+    }
+
+    return blocks;
+}
+
+/** The same timeline cut into blockSize blocks at sampleRate. Energy is spread
+    evenly within each captured block, so a re-cut block's sum of squares is
+    the time-weighted mix of the captured blocks it overlaps.
+*/
+static std::vector<ReplayBlock> reblock (const std::vector<EnvelopeCapture::Record>& records, const ActivityDetector& detector,
+                                         int sampleRate, int blockSize)
+{
+    std::vector<ReplayBlock> blocks;
+
+    struct Pending
+    {
+        bool started = false;
+        double startMs = 0.0;
+        double filled = 0.0;
+        bool bypassed = false;
+        bool midiActive = false;
+        int numChannels = 0;
+        double energy[EnvelopeCapture::maxChannels] = {};
+    } pending;
+
+    auto emit = [&] (int numSamples)
+    {
+        bool active = pending.midiActive;
+        for (int channel = 0; channel < pending.numChannels; ++channel)
+            active = active || detector.isChannelActive (pending.energy[channel], numSamples);
+
+        blocks.push_back ({ (int64_t) pending.startMs, numSamples, (double) sampleRate, active && ! pending.bypassed });
+        pending = {};
+    };
+
+    auto emitPartial = [&]
+    {
+        if (pending.started && pending.filled >= 1.0)
+            emit ((int) std::lround (pending.filled));
+        pending = {};
+    };
+
+    double clockMs = records.empty() ? 0.0 : (double) records.front().nowMs;
+    for (const auto& record : records)
+    {
+        if ((double) record.nowMs > clockMs + gapThresholdMs)
+        {
+            emitPartial();
+            clockMs = (double) record.nowMs;
+        }
+
+        if (record.sampleRate == 0 || record.numSamples == 0)
+            continue;
+
+        auto remaining = record.numSamples * (double) sampleRate / record.sampleRate;
+        double consumed = 0.0;
+
+        while (remaining > 1.0e-9)
+        {
+            if (! pending.started)
+            {
+                pending.started = true;
+                pending.startMs = clockMs + consumed * 1000.0 / sampleRate;
+                pending.bypassed = (record.flags & EnvelopeCapture::bypassed) != 0;
+            }
+
+            auto take = juce::jmin (remaining, blockSize - pending.filled);
+            pending.numChannels = juce::jmax (pending.numChannels, (int) record.numChannels);
+            pending.midiActive = pending.midiActive || (record.flags & EnvelopeCapture::midiActive) != 0;
+            for (int channel = 0; channel < record.numChannels; ++channel)
+                pending.energy[channel] += record.sumOfSquares[channel] / record.numSamples * take;
+
+            pending.filled += take;
+            remaining -= take;
+            consumed += take;
+
+            if (pending.filled >= blockSize - 1.0e-6)
+                emit (blockSize);
+        }
+
+        clockMs += record.numSamples * 1000.0 / record.sampleRate;
+    }
+
+    emitPartial();
+    return blocks;
+}
+
+/** Runs the blocks through the same accounting as processBlock: time goes to
+    the shared segment, harvested up to each window that closes (as the leader
+    does), and whatever the segment can't take is counted locally.
+*/
+static WindowMap account (const std::vector<ReplayBlock>& blocks, int windowSeconds, SharedActivitySegment& segment)
+{
+    WindowMap windows;
+    if (blocks.empty())
+        return windows;
+
+    const auto group = SharedActivitySegment::groupFor ("Replay", "replay");
+    auto harvest = [&windows, &segment, group] (int64_t cutoff)
+    {
+        segment.harvest (group, cutoff, [&windows] (int64_t window, int milliseconds) { windows[window] += milliseconds; });
+    };
+
+    ActivityAccountant accountant;
+    auto collect = [&windows, &harvest, &accountant] (const ActivityAccountant::Outcome& outcome)
+    {
+        if (! outcome.windowRolled)
+            return;
+
+        if (outcome.closedMilliseconds > 0)
+            windows[outcome.closedWindow] += outcome.closedMilliseconds;
+
+        // everything before the new window; the timeline may already have marked later ones
+        harvest (accountant.getCurrentWindow());
+    };
+
+    accountant.reset (ActivityAccountant::windowStartFor (blocks.front().nowMs, windowSeconds));
+
+    for (const auto& block : blocks)
+        collect (accountant.process ({ block.nowMs, ActivityAccountant::windowStartFor (block.nowMs, windowSeconds),
+                                       block.numSamples, block.sampleRate, block.active },
+                                     [&segment, group] (int64_t fromMs, int64_t toMs) { return segment.markActive (group, fromMs, toMs); }));
+
+    collect (accountant.flush());
+    harvest (std::numeric_limits<int64_t>::max());
+    return windows;
+}
+
+//==============================================================================
+static juce::var toVar (const WindowMap& windows)
+{
+    auto* object = new juce::DynamicObject();
+    for (const auto& [window, milliseconds] : windows)
+        object->setProperty (juce::String (window), milliseconds);
+    return juce::var (object);
+}
+
+static WindowMap fromVar (const juce::var& value)
+{
+    WindowMap windows;
+    if (auto* object = value.getDynamicObject())
+        for (const auto& property : object->getProperties())
+            windows[property.name.toString().getLargeIntValue()] = (int) property.value;
+    return windows;
+}
+
+static int64_t totalOf (const WindowMap& windows)
+{
+    int64_t total = 0;
+    for (const auto& entry : windows)
+        total += entry.second;
+    return total;
+}
+
+/** Prints every window that differs and returns how many did. */
+static int diff (const juce::String& variant, const WindowMap& expected, const WindowMap& actual, int toleranceMs)
+{
+    std::map<int64_t, std::pair<int, int>> merged;
+    for (const auto& [window, milliseconds] : expected) merged[window].first = milliseconds;
+    for (const auto& [window, milliseconds] : actual)   merged[window].second = milliseconds;
+
+    int differences = 0;
+    for (const auto& [window, values] : merged)
+    {
+        if (std::abs (values.first - values.second) <= toleranceMs)
+            continue;
+
+        if (++differences <= 10)
+            std::cout << "    " << variant << " window " << window << ": expected " << values.first << " ms, got " << values.second << " ms" << std::endl;
+    }
+
+    if (differences > 10)
+        std::cout << "    " << variant << ": " << (differences - 10) << " more differing windows" << std::endl;
+
+    return differences;
+}
+
+static bool replay (const juce::File& captureFile, const ReplayConfig& config, SharedActivitySegment& segment)
+{
+    juce::FileInputStream input (captureFile);
+    if (input.failedToOpen())
+    {
+        std::cerr << "Could not open " << captureFile.getFullPathName() << std::endl;
+        return false;
+    }
+
+    EnvelopeCapture::Header header;
+    std::vector<EnvelopeCapture::Record> records;
+    auto result = EnvelopeCapture::read (input, header, records);
+    if (result.failed())
+    {
+        std::cerr << captureFile.getFileName() << ": " << result.getErrorMessage() << std::endl;
+        return false;
+    }
+
+    const ActivityDetector detector (header.thresholdDb);
+    auto started = juce::Time::getMillisecondCounterHiRes();
+
+    std::vector<std::pair<juce::String, WindowMap>> variants;
+    int64_t blocksReplayed = 0;
+
+    auto native = nativeBlocks (records, detector);
+    blocksReplayed += (int64_t) native.size();
+    variants.push_back ({ "native", account (native, header.windowSeconds, segment) });
+
+    for (auto rate : config.sampleRates)
+    {
+        for (auto size : config.blockSizes)
+        {
+            auto blocks = reblock (records, detector, rate, size);
+            blocksReplayed += (int64_t) blocks.size();
+            variants.push_back ({ juce::String (rate) + "x" + juce::String (size), account (blocks, header.windowSeconds, segment) });
+        }
+    }
+
+    auto elapsedMs = juce::jmax (0.001, juce::Time::getMillisecondCounterHiRes() - started);
+    auto sessionMs = records.empty() ? 0.0 : (double) (records.back().nowMs - records.front().nowMs);
+
+    int mismatchedVerdicts = 0;
+    for (size_t i = 0; i < records.size(); ++i)
+    {
+        auto flags = records[i].flags;
+        auto captured = (flags & EnvelopeCapture::detectedActive) != 0
+                     || ((flags & EnvelopeCapture::midiActive) != 0 && (flags & EnvelopeCapture::bypassed) == 0);
+        if (native[i].active != captured)
+            ++mismatchedVerdicts;
+    }
+
+    std::cout << captureFile.getFileName() << ": " << records.size() << " blocks, "
+              << juce::String (sessionMs / 60000.0, 1) << " min, " << variants.size() << " variants, "
+              << juce::String (sessionMs * (double) variants.size() / elapsedMs, 0) << "x realtime" << std::endl;
+
+    if (mismatchedVerdicts > 0)
+        std::cout << "  " << mismatchedVerdicts << " blocks where the replayed detector disagrees with the captured verdict" << std::endl;
+
+    const auto& nativeWindows = variants.front().second;
+    for (const auto& [name, windows] : variants)
+    {
+        int maxDrift = 0;
+        for (const auto& [window, milliseconds] : windows)
+        {
+            auto found = nativeWindows.find (window);
+            maxDrift = juce::jmax (maxDrift, std::abs (milliseconds - (found != nativeWindows.end() ? found->second : 0)));
+        }
+
+        std::cout << "  " << name.paddedRight (' ', 12) << windows.size() << " windows, " << totalOf (windows)
+                  << " ms, max drift from native " << maxDrift << " ms" << std::endl;
+    }
+
+    bool ok = true;
+
+    if (config.toleranceMs >= 0)
+        for (const auto& [name, windows] : variants)
+            if (diff (name + " vs native", nativeWindows, windows, config.toleranceMs) > 0)
+                ok = false;
+
+    auto goldenFile = captureFile.withFileExtension ("golden.json");
+
+    if (config.writeGolden)
+    {
+        auto* variantsObject = new juce::DynamicObject();
+        for (const auto& [name, windows] : variants)
+            variantsObject->setProperty (name, toVar (windows));
+
+        auto* golden = new juce::DynamicObject();
+        golden->setProperty ("windowSeconds", header.windowSeconds);
+        golden->setProperty ("variants", juce::var (variantsObject));
+
+        if (! goldenFile.replaceWithText (juce::JSON::toString (juce::var (golden))))
+        {
+            std::cerr << "Could not write " << goldenFile.getFullPathName() << std::endl;
+            return false;
+        }
+
+        std::cout << "  wrote " << goldenFile.getFileName() << std::endl;
+        return ok;
+    }
+
+    if (! goldenFile.existsAsFile())
+    {
+        std::cout << "  no " << goldenFile.getFileName() << ", run with --write-golden to create it" << std::endl;
+        return ok;
+    }
+
+    auto golden = juce::JSON::parse (goldenFile);
+    auto goldenVariants = golden.getProperty ("variants", {});
+    for (const auto& [name, windows] : variants)
+    {
+        if (! goldenVariants.hasProperty (name))
+        {
+            std::cout << "  " << name << ": not in golden" << std::endl;
+            continue;
+        }
+
+        if (diff (name, fromVar (goldenVariants.getProperty (name, {})), windows, 0) > 0)
+            ok = false;
+    }
+
+    std::cout << "  " << (ok ? "PASS" : "FAIL") << std::endl;
+    return ok;
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ArgumentList args (argc, argv);
+    auto config = ReplayConfig::fromArguments (args);
+
+    if (args.containsOption ("--help|-h") || config.captures.isEmpty())
+    {
+        std::cout << "Usage: " << args.executableName << " [options] capture.sbenv...\n"
+                  << "  --rates=LIST           sample rates to re-block to (default 44100,48000,96000)\n"
+                  << "  --block-sizes=LIST     buffer sizes to re-block to (default 64,256,1024)\n"
+                  << "  --tolerance-ms=N       also fail if any variant's window differs from native by more than N\n"
+                  << "  --write-golden         write <capture>.golden.json instead of comparing against it\n";
+        return config.captures.isEmpty() && ! args.containsOption ("--help|-h") ? 1 : 0;
+    }
+
+    // a segment of its own, so a replay never merges with (or harvests) a running plugin's time
+   #if JUCE_LINUX
+    const auto segmentName = "/signalbash-replay-" + std::to_string (getpid());
+    SharedActivitySegment::useSegmentName (segmentName);
+   #endif
+
+    bool ok = true;
+    {
+        SharedActivitySegment segment;
+        for (auto& path : config.captures)
+            ok = replay (juce::File::getCurrentWorkingDirectory().getChildFile (path), config, segment) && ok;
+    }
+
+   #if JUCE_LINUX
+    shm_unlink (segmentName.c_str());
+   #endif
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,234 @@
+/*
+  ==============================================================================
+
+    RequestBench.cpp
+
+    Counts heap allocations and time per /submit request on the calling
+    thread, for the RestRequest builder (RestRequest.h) against the copying
+    builder it replaced, and end to end through execute() against the
+    in-process mock API. Allocations are counted by replacing the global
+    operator new, per thread, so the mock server's own threads don't show up.
+
+  ==============================================================================
+*/
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <JuceHeader.h>
+
+#include "RestRequest.h"
+#include "DeduplicationID.h"
+#include "../mock_server/MockApiServer.h"
+
+//==============================================================================
+static thread_local int64_t threadAllocations = 0;
+
+void* operator new (std::size_t size)
+{
+    ++threadAllocations;
+    if (auto* p = std::malloc (size == 0 ? 1 : size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[] (std::size_t size)                  { return operator new (size); }
+void operator delete (void* p) noexcept                  { std::free (p); }
+void operator delete[] (void* p) noexcept                { std::free (p); }
+void operator delete (void* p, std::size_t) noexcept     { std::free (p); }
+void operator delete[] (void* p, std::size_t) noexcept   { std::free (p); }
+
+//==============================================================================
+struct RequestBenchConfig
+{
+    int iterations = 2000;
+    int windows = 12;
+    int port = 7577;
+
+    static RequestBenchConfig fromArguments (const juce::ArgumentList& args)
+    {
+        RequestBenchConfig config;
+        auto intArg = [&args] (const char* name, int fallback) { return args.containsOption (name) ? args.getValueForOption (name).getIntValue() : fallback; };
+
+        config.iterations = juce::jmax (1, intArg ("--iterations", config.iterations));
+        config.windows    = juce::jmax (1, intArg ("--windows", config.windows));
+        config.port       = intArg ("--port", config.port);
+        return config;
+    }
+};
+
+/** What commitActivity() builds once per submission, before the request task runs. */
+struct SubmitPayload
+{
+    juce::var activity, idempotencyKeys;
+    juce::String batchKey;
+
+    explicit SubmitPayload (int windows)
+    {
+        auto* activityObj = new juce::DynamicObject();
+        auto* keysObj = new juce::DynamicObject();
+        DeduplicationID::BatchKey batch;
+        const auto instance = DeduplicationID::generate();
+
+        for (int i = 0; i < windows; ++i)
+        {
+            const auto window = 1700000000 + i * 10;
+            const auto key = DeduplicationID::idempotencyKey (instance, window);
+            activityObj->setProperty (juce::String (window), 10000 - i);
+            keysObj->setProperty (juce::String (window), juce::String (key));
+            batch.add (key);
+        }
+
+        activity = juce::var (activityObj);
+        idempotencyKeys = juce::var (keysObj);
+        batchKey = batch.toString();
+    }
+};
+
+//==============================================================================
+/** The builder before RestRequest became move-only: every call copied the request. */
+class CopyingRequest
+{
+public:
+    CopyingRequest post (const juce::String& endpointToUse)
+    {
+        CopyingRequest req (*this);
+        req.verb = "POST";
+        req.endpoint = endpointToUse;
+        return req;
+    }
+
+    CopyingRequest field (const juce::String& name, const juce::var& value)
+    {
+        fields.setProperty (name, value);
+        return *this;
+    }
+
+    CopyingRequest header (const juce::String& name, const juce::String& value)
+    {
+        CopyingRequest req (*this);
+        headers.set (name, value);
+        return req;
+    }
+
+    juce::MemoryBlock body() const
+    {
+        juce::MemoryOutputStream output;
+        fields.writeAsJSON (output, juce::JSON::FormatOptions());
+        return output.getMemoryBlock();
+    }
+
+private:
+    juce::URL url;
+    juce::StringPairArray headers;
+    juce::String verb, endpoint;
+    juce::DynamicObject fields;
+};
+
+//==============================================================================
+struct Measurement
+{
+    double allocationsPerRequest = 0.0;
+    double microsPerRequest = 0.0;
+};
+
+template <typename Fn>
+static Measurement measure (int iterations, Fn&& buildOne)
+{
+    const auto allocationsBefore = threadAllocations;
+    const auto start = juce::Time::getHighResolutionTicks();
+
+    for (int i = 0; i < iterations; ++i)
+        buildOne();
+
+    const auto seconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start);
+    return { (double) (threadAllocations - allocationsBefore) / iterations, seconds * 1.0e6 / iterations };
+}
+
+static void print (const char* name, const Measurement& m)
+{
+    std::cout << std::left << std::setw (28) << name << std::right << std::fixed
+              << std::setprecision (1) << std::setw (10) << m.allocationsPerRequest << " allocs"
+              << std::setprecision (2) << std::setw (12) << m.microsPerRequest << " us" << std::endl;
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ArgumentList args (argc, argv);
+
+    if (args.containsOption ("--help|-h"))
+    {
+        std::cout << "Usage: " << args.executableName << " [options]\n"
+                  << "  --iterations=N           requests per measurement (default 2000)\n"
+                  << "  --windows=N              activity windows per request (default 12)\n"
+                  << "  --port=N                 port for the in-process mock API (default 7577)\n";
+        return 0;
+    }
+
+    auto config = RequestBenchConfig::fromArguments (args);
+    const SubmitPayload payload (config.windows);
+    const juce::String endpoint = "http://127.0.0.1:" + juce::String (config.port) + "/submit";
+
+    auto buildLean = [&] (RestRequest& request) -> RestRequest&
+    {
+        request.header ("Content-Type", "application/json");
+        request.header ("Idempotency-Key", payload.batchKey);
+        return request.post (endpoint)
+            .field ("host", "Bench")
+            .field ("plugin_version", "1.1.0")
+            .field ("session_key", "bench-session-key")
+            .field ("dd_id", "0123456789abcdef0123456789abcdef")
+            .field ("activity", payload.activity)
+            .field ("idempotency_keys", payload.idempotencyKeys)
+            .expect (RestRequest::ResponseMode::statusOnly);
+    };
+
+    std::cout << config.windows << " windows per request, " << config.iterations << " requests" << std::endl;
+
+    print ("build, RestRequest", measure (config.iterations, [&]
+    {
+        RestRequest request;
+        buildLean (request).closeBody();
+    }));
+
+    print ("build, copying builder", measure (config.iterations, [&]
+    {
+        auto body = CopyingRequest()
+            .header ("Content-Type", "application/json")
+            .header ("Idempotency-Key", payload.batchKey)
+            .post (endpoint)
+            .field ("host", "Bench")
+            .field ("plugin_version", "1.1.0")
+            .field ("session_key", "bench-session-key")
+            .field ("dd_id", "0123456789abcdef0123456789abcdef")
+            .field ("activity", payload.activity)
+            .field ("idempotency_keys", payload.idempotencyKeys)
+            .body();
+        juce::ignoreUnused (body);
+    }));
+
+    MockServerConfig serverConfig;
+    serverConfig.port = config.port;
+    MockApiServer server (serverConfig);
+    if (! server.start())
+    {
+        std::cerr << "Could not listen on 127.0.0.1:" << config.port << std::endl;
+        return 1;
+    }
+
+    // far fewer round trips: the socket dominates, the interesting part is what the builder adds
+    int failures = 0;
+    print ("build + execute", measure (juce::jmax (1, config.iterations / 20), [&]
+    {
+        RestRequest request;
+        if (buildLean (request).execute().status != 200)
+            ++failures;
+    }));
+
+    if (failures > 0)
+        std::cout << failures << " requests failed" << std::endl;
+
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,236 @@
+/*
+  ==============================================================================
+
+    SegmentTest.cpp
+
+    Checks SharedActivitySegment across processes, the way sandboxed plugin
+    hosts use it: the test spawns itself as a number of child processes, in
+    groups sharing a host and session key, plus some without a key, all on a
+    segment of their own. Every child joins, checks whether it leads at the
+    same moment, and marks overlapping spans of a fixed past timeline. The
+    parent then verifies:
+
+    - exactly one leader per keyed group, and none among the keyless children;
+    - keyless children can't mark anything, so they keep their time locally;
+    - harvesting a group yields exactly the union of its own children's spans,
+      untouched by the other groups marking the same wall-clock time.
+
+    Exits with 1 on any mismatch. Linux only, like the cross-process segment.
+
+  ==============================================================================
+*/
+
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <JuceHeader.h>
+
+#include "SharedActivitySegment.h"
+
+//==============================================================================
+namespace
+{
+    // a fixed past timeline: 10 repetitions, 20 s apart, each marked by every child of a group
+    constexpr int64_t timelineStartMs = 1700000000000;
+    constexpr int repetitions = 10;
+    constexpr int64_t repetitionStrideMs = 20000;
+    constexpr int64_t spanMs = 6000;
+
+    struct GroupSpec
+    {
+        const char* host;
+        const char* sessionKey;
+        int children;
+        int64_t offsetStepMs;       // child i marks [i * offsetStepMs, i * offsetStepMs + spanMs) per repetition
+    };
+
+    const GroupSpec groups[] = {
+        { "Ableton Live",  "segment-test-key-a", 3, 2500 },     // union 11000 ms per repetition
+        { "Ableton Live",  "segment-test-key-b", 3, 4000 },     // union 14000 ms
+        { "Bitwig Studio", "segment-test-key-a", 1, 0 },        // same key, other host: 6000 ms of its own
+        { "Ableton Live",  "",                   2, 1000 },     // no key: never merges, never leads
+    };
+
+    int64_t expectedUnionMs (const GroupSpec& spec)
+    {
+        if (juce::String (spec.sessionKey).isEmpty())
+            return 0;
+
+        return repetitions * ((spec.children - 1) * spec.offsetStepMs + spanMs);
+    }
+
+    void sleepUntil (int64_t wallMs)
+    {
+        while (juce::Time::currentTimeMillis() < wallMs)
+            std::this_thread::sleep_for (std::chrono::milliseconds (5));
+    }
+}
+
+//==============================================================================
+/** One participant: joins, checks leadership at startMs, marks its spans, stays
+    alive until every sibling has checked, then prints what happened.
+*/
+static int runChild (const juce::ArgumentList& args)
+{
+    const auto group = (uint32_t) args.getValueForOption ("--group").getLargeIntValue();
+    const auto index = args.getValueForOption ("--index").getIntValue();
+    const auto step = args.getValueForOption ("--step").getLargeIntValue();
+    const auto startMs = args.getValueForOption ("--start").getLargeIntValue();
+
+    SharedActivitySegment::useSegmentName (args.getValueForOption ("--segment").toStdString());
+    juce::SharedResourcePointer<SharedActivitySegment> segment;
+    if (! segment->isShared())
+    {
+        std::cout << "error=not-shared" << std::endl;
+        return 1;
+    }
+
+    auto participant = segment->join (group);
+    sleepUntil (startMs);
+    const auto leader = segment->isLeader (participant);
+
+    int accepted = 0, rejected = 0;
+    for (int rep = 0; rep < repetitions; ++rep)
+    {
+        const auto from = timelineStartMs + rep * repetitionStrideMs + index * step;
+        if (segment->markActive (group, from, from + spanMs))
+            ++accepted;
+        else
+            ++rejected;
+    }
+
+    sleepUntil (startMs + 1500);
+    segment->leave (participant);
+
+    std::cout << "valid=" << (participant.isValid() ? 1 : 0) << " leader=" << (leader ? 1 : 0)
+              << " accepted=" << accepted << " rejected=" << rejected << std::endl;
+    return 0;
+}
+
+//==============================================================================
+struct ChildResult
+{
+    int group = 0;
+    juce::StringPairArray values;
+};
+
+static juce::StringPairArray parseResult (const juce::String& output)
+{
+    juce::StringPairArray values;
+    // the last line; anything before it is the segment's own logging
+    for (auto& token : juce::StringArray::fromTokens (output.trim().fromLastOccurrenceOf ("\n", false, false), " ", {}))
+        values.set (token.upToFirstOccurrenceOf ("=", false, false), token.fromFirstOccurrenceOf ("=", false, false));
+    return values;
+}
+
+int main (int argc, char* argv[])
+{
+    juce::ArgumentList args (argc, argv);
+
+    if (args.containsOption ("--child"))
+        return runChild (args);
+
+    if (args.containsOption ("--help|-h"))
+    {
+        std::cout << "Usage: " << args.executableName << "\n"
+                  << "  Spawns itself as participants of a private shared activity segment and checks\n"
+                  << "  leader election and per-group merging across processes. Exits 1 on failure.\n";
+        return 0;
+    }
+
+    const auto segmentName = "/signalbash-segment-test-" + std::to_string (getpid());
+    shm_unlink (segmentName.c_str());
+
+    // far enough ahead that every child has joined before any checks leadership
+    const auto startMs = juce::Time::currentTimeMillis() + 2000;
+    const auto executable = juce::File::getSpecialLocation (juce::File::currentExecutableFile).getFullPathName();
+
+    // interleaved, so the groups' slots are too and a leader has lower slots of other groups below it
+    std::vector<std::pair<int, std::unique_ptr<juce::ChildProcess>>> children;
+    const auto numGroups = (int) std::size (groups);
+    for (int index = 0; ; ++index)
+    {
+        bool spawned = false;
+        for (int g = 0; g < numGroups; ++g)
+        {
+            if (index >= groups[g].children)
+                continue;
+
+            auto child = std::make_unique<juce::ChildProcess>();
+            juce::StringArray command { executable, "--child",
+                                        "--segment=" + juce::String (segmentName),
+                                        "--group=" + juce::String ((juce::int64) SharedActivitySegment::groupFor (groups[g].host, groups[g].sessionKey)),
+                                        "--index=" + juce::String (index),
+                                        "--step=" + juce::String (groups[g].offsetStepMs),
+                                        "--start=" + juce::String (startMs) };
+            if (! child->start (command, juce::ChildProcess::wantStdOut))
+            {
+                std::cerr << "Could not start " << executable << std::endl;
+                return 1;
+            }
+
+            children.emplace_back (g, std::move (child));
+            spawned = true;
+        }
+
+        if (! spawned)
+            break;
+    }
+
+    std::vector<ChildResult> results;
+    for (auto& [g, child] : children)
+        results.push_back ({ g, parseResult (child->readAllProcessOutput()) });
+
+    bool ok = true;
+    auto fail = [&ok] (const juce::String& message)
+    {
+        std::cout << "FAIL: " << message << std::endl;
+        ok = false;
+    };
+
+    SharedActivitySegment::useSegmentName (segmentName);
+    juce::SharedResourcePointer<SharedActivitySegment> segment;
+
+    for (int g = 0; g < numGroups; ++g)
+    {
+        const auto& spec = groups[g];
+        const auto group = SharedActivitySegment::groupFor (spec.host, spec.sessionKey);
+        const auto keyed = group != 0;
+        const auto name = juce::String (spec.host) + " / " + (keyed ? juce::String (spec.sessionKey) : juce::String ("(no key)"));
+
+        int leaders = 0;
+        for (auto& result : results)
+        {
+            if (result.group != g)
+                continue;
+
+            if (result.values["valid"] != "1")
+                fail (name + ": child could not join (" + result.values.getDescription() + ")");
+
+            leaders += result.values["leader"].getIntValue();
+            const auto accepted = result.values["accepted"].getIntValue();
+            if (keyed && accepted != repetitions)
+                fail (name + ": " + juce::String (repetitions - accepted) + " marks rejected");
+            if (! keyed && accepted != 0)
+                fail (name + ": a keyless child merged " + juce::String (accepted) + " spans");
+        }
+
+        if (leaders != (keyed ? 1 : 0))
+            fail (name + ": " + juce::String (leaders) + " leaders");
+
+        int64_t harvestedMs = 0;
+        segment->harvest (group, std::numeric_limits<int64_t>::max(), [&harvestedMs] (int64_t, int milliseconds) { harvestedMs += milliseconds; });
+        if (harvestedMs != expectedUnionMs (spec))
+            fail (name + ": harvested " + juce::String (harvestedMs) + " ms, expected " + juce::String (expectedUnionMs (spec)));
+
+        std::cout << name << ": " << leaders << " leader(s), " << harvestedMs << " ms" << std::endl;
+    }
+
+    shm_unlink (segmentName.c_str());
+    std::cout << (ok ? "PASS" : "FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
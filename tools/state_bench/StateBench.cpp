@@ -0,0 +1,284 @@
+/*
+  ==============================================================================
+
+    StateBench.cpp
+
+    Runs the processor's cross-thread state traffic for hundreds of instances
+    at once: audio threads run the per-block hot path over the instances they
+    own, a message thread polls every instance the way the editors and timers
+    do, and worker threads flip connection and submission flags. Reports the
+    audio-thread cost per block for the current cache-line-partitioned layout
+    (ProcessorState.h) against the packed, seq_cst layout it replaced.
+
+    Pin every thread onto a small core set (--cores) to reproduce a busy host.
+
+  ==============================================================================
+*/
+
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <JuceHeader.h>
+
+#if JUCE_LINUX
+ #include <pthread.h>
+ #include <sched.h>
+#endif
+
+#include "ProcessorState.h"
+
+struct StateBenchConfig
+{
+    int instances = 256;
+    int audioThreads = 4;
+    int workerThreads = 2;
+    int seconds = 5;
+    std::vector<int> cores;
+
+    static StateBenchConfig fromArguments (const juce::ArgumentList& args)
+    {
+        StateBenchConfig config;
+        auto intArg = [&args] (const char* name, int fallback) { return args.containsOption (name) ? args.getValueForOption (name).getIntValue() : fallback; };
+
+        config.instances     = juce::jmax (1, intArg ("--instances", config.instances));
+        config.audioThreads  = juce::jmax (1, intArg ("--audio-threads", config.audioThreads));
+        config.workerThreads = juce::jmax (0, intArg ("--worker-threads", config.workerThreads));
+        config.seconds       = juce::jmax (1, intArg ("--seconds", config.seconds));
+
+        // "0-3" or "0,2,4"
+        if (args.containsOption ("--cores"))
+        {
+            for (auto& range : juce::StringArray::fromTokens (args.getValueForOption ("--cores"), ",", {}))
+            {
+                auto first = range.upToFirstOccurrenceOf ("-", false, false).getIntValue();
+                auto last = range.contains ("-") ? range.fromFirstOccurrenceOf ("-", false, false).getIntValue() : first;
+                for (int core = first; core <= last; ++core)
+                    config.cores.push_back (core);
+            }
+        }
+
+        return config;
+    }
+};
+
+//==============================================================================
+/** The layout before the split: audio, message and worker fields interleaved, all seq_cst. */
+struct PackedState
+{
+    std::atomic<int> activity { 0 };
+    std::atomic<bool> connectionHealthy { true };
+    std::atomic<bool> signalHot { false };
+    std::atomic<bool> sessionKeyValidated { false };
+    std::atomic<int64_t> currentActivityBlock { 0 };
+    std::atomic<bool> submissionInFlight { false };
+    std::atomic<int64_t> lastActiveBlockTimestamp { 0 };
+    std::atomic<bool> deepIdle { false };
+    int currentRecordedActivityMilliseconds = 0;
+    std::atomic<int64_t> lastProcessBlockCallTimestamp { -1 };
+
+    void processBlock (int64_t nowMs, int64_t window, bool active)
+    {
+        if (currentActivityBlock.load() != window)
+        {
+            currentActivityBlock.store (window);
+            currentRecordedActivityMilliseconds = 0;
+        }
+
+        if (active)
+        {
+            signalHot.store (true);
+            lastActiveBlockTimestamp.store (nowMs);
+            if (deepIdle.load()) juce::ignoreUnused (nowMs);
+            ++activity;
+            currentRecordedActivityMilliseconds += 5;
+        }
+        else
+        {
+            signalHot.store (false);
+        }
+
+        lastProcessBlockCallTimestamp.store (nowMs);
+    }
+
+    int poll() const
+    {
+        return (int) signalHot.load() + activity.load() + (int) connectionHealthy.load() + (int) sessionKeyValidated.load();
+    }
+
+    void workerUpdate (bool healthy)
+    {
+        connectionHealthy.store (healthy);
+        submissionInFlight.store (! healthy);
+    }
+};
+
+/** Mirrors SignalbashAudioProcessor::processAudioBlock and its readers. */
+struct PartitionedState
+{
+    AudioThreadState audio;
+    ControlState control;
+
+    void processBlock (int64_t nowMs, int64_t window, bool active)
+    {
+        auto outcome = audio.accountant.process ({ nowMs, window, 240, 48000.0, active }, [] (int64_t, int64_t) { return false; });
+        if (outcome.windowRolled)
+            audio.currentActivityBlock.store (window, std::memory_order_relaxed);
+
+        if (audio.signalHot.load (std::memory_order_relaxed) != active)
+            audio.signalHot.store (active, std::memory_order_relaxed);
+
+        if (active)
+        {
+            audio.lastActiveBlockTimestamp.store (nowMs, std::memory_order_relaxed);
+            if (control.deepIdle.load (std::memory_order_relaxed)) juce::ignoreUnused (nowMs);
+            audio.activity.fetch_add (1, std::memory_order_relaxed);
+        }
+    }
+
+    int poll() const
+    {
+        return (int) audio.signalHot.load (std::memory_order_relaxed) + audio.activity.load (std::memory_order_relaxed)
+             + (int) control.connectionHealthy.load (std::memory_order_relaxed) + (int) control.sessionKeyValidated.load (std::memory_order_relaxed);
+    }
+
+    void workerUpdate (bool healthy)
+    {
+        control.connectionHealthy.store (healthy, std::memory_order_relaxed);
+        control.submissionInFlight.store (! healthy, std::memory_order_release);
+    }
+};
+
+//==============================================================================
+static void pinToCore (const StateBenchConfig& config, int threadIndex)
+{
+   #if JUCE_LINUX
+    if (config.cores.empty())
+        return;
+
+    cpu_set_t set;
+    CPU_ZERO (&set);
+    CPU_SET (config.cores[(size_t) threadIndex % config.cores.size()], &set);
+    pthread_setaffinity_np (pthread_self(), sizeof (set), &set);
+   #else
+    juce::ignoreUnused (config, threadIndex);
+   #endif
+}
+
+struct BenchResult
+{
+    double nsPerBlock = 0.0;
+    double blocksPerSecond = 0.0;
+};
+
+template <typename State>
+static BenchResult run (const StateBenchConfig& config)
+{
+    // separate allocations, like separate plugin instances
+    std::vector<std::unique_ptr<State>> instances;
+    for (int i = 0; i < config.instances; ++i)
+        instances.push_back (std::make_unique<State>());
+
+    std::atomic<bool> running { true };
+    std::atomic<int64_t> totalBlocks { 0 };
+    std::atomic<int64_t> totalAudioNanos { 0 };
+    std::atomic<int> sink { 0 };
+    std::vector<std::thread> threads;
+    int threadIndex = 0;
+
+    for (int t = 0; t < config.audioThreads; ++t)
+    {
+        threads.emplace_back ([&, t, index = threadIndex++]
+        {
+            pinToCore (config, index);
+            int64_t blocks = 0;
+            const int64_t blocksPerPass = (config.instances - t + config.audioThreads - 1) / config.audioThreads;
+            auto start = juce::Time::getHighResolutionTicks();
+
+            while (running.load (std::memory_order_relaxed))
+            {
+                auto nowMs = (int64_t) juce::Time::getMillisecondCounter();
+                for (int i = t; i < config.instances; i += config.audioThreads)
+                    instances[(size_t) i]->processBlock (nowMs, nowMs / 10000, ((blocks + i) & 7) != 0);
+                blocks += blocksPerPass;
+            }
+
+            auto elapsed = juce::Time::getHighResolutionTicks() - start;
+            totalBlocks += blocks;
+            totalAudioNanos += (int64_t) (juce::Time::highResolutionTicksToSeconds (elapsed) * 1.0e9);
+        });
+    }
+
+    threads.emplace_back ([&, index = threadIndex++]
+    {
+        pinToCore (config, index);
+        int acc = 0;
+        while (running.load (std::memory_order_relaxed))
+            for (auto& instance : instances)
+                acc += instance->poll();
+        sink += acc;
+    });
+
+    for (int w = 0; w < config.workerThreads; ++w)
+    {
+        threads.emplace_back ([&, w, index = threadIndex++]
+        {
+            pinToCore (config, index);
+            bool healthy = (w & 1) == 0;
+            while (running.load (std::memory_order_relaxed))
+            {
+                for (int i = w; i < config.instances; i += config.workerThreads)
+                    instances[(size_t) i]->workerUpdate (healthy);
+                healthy = ! healthy;
+            }
+        });
+    }
+
+    std::this_thread::sleep_for (std::chrono::seconds (config.seconds));
+    running = false;
+    for (auto& thread : threads)
+        thread.join();
+
+    BenchResult result;
+    auto blocks = (double) juce::jmax<int64_t> (1, totalBlocks.load());
+    result.nsPerBlock = (double) totalAudioNanos.load() / blocks;
+    result.blocksPerSecond = blocks / (double) config.seconds;
+    return result;
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ArgumentList args (argc, argv);
+
+    if (args.containsOption ("--help|-h"))
+    {
+        std::cout << "Usage: " << args.executableName << " [options]\n"
+                  << "  --instances=N        simulated plugin instances (default 256)\n"
+                  << "  --audio-threads=N    threads running processBlock (default 4)\n"
+                  << "  --worker-threads=N   threads writing network state (default 2)\n"
+                  << "  --seconds=N          duration of each layout's run (default 5)\n"
+                  << "  --cores=LIST         pin all threads onto these cores, e.g. 0-3 (Linux)\n";
+        return 0;
+    }
+
+    auto config = StateBenchConfig::fromArguments (args);
+
+    std::cout << config.instances << " instances, " << config.audioThreads << " audio / 1 message / "
+              << config.workerThreads << " worker threads, cache line " << cacheLineSize << " bytes" << std::endl;
+
+    auto report = [] (const char* name, const BenchResult& result)
+    {
+        std::cout << "  " << juce::String (name).paddedRight (' ', 12) << juce::String (result.nsPerBlock, 1) << " ns/block, "
+                  << juce::String (result.blocksPerSecond / 1.0e6, 2) << " M blocks/s" << std::endl;
+    };
+
+    auto packed = run<PackedState> (config);
+    report ("packed", packed);
+
+    auto partitioned = run<PartitionedState> (config);
+    report ("partitioned", partitioned);
+
+    std::cout << "  speedup     " << juce::String (packed.nsPerBlock / juce::jmax (0.001, partitioned.nsPerBlock), 2) << "x" << std::endl;
+    return 0;
+}
@@ -0,0 +1,227 @@
+/*
+  ==============================================================================
+
+    StatsReader.cpp
+
+    Lists the live state every running Signalbash instance publishes through
+    StatsExport: one shared-memory segment per process under /dev/shm, mapped
+    read-only and read under its seqlock, so polling never blocks or slows the
+    plugin. Segments left behind by processes that died are reported as stale
+    and can be removed with --clean.
+
+  ==============================================================================
+*/
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <signal.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <JuceHeader.h>
+
+#include "StatsExport.h"
+
+struct StatsReaderConfig
+{
+    uint32_t uid = getuid();
+    int watchMs = 0;
+    bool json = false;
+    bool clean = false;
+
+    static StatsReaderConfig fromArguments (const juce::ArgumentList& args)
+    {
+        StatsReaderConfig config;
+
+        if (args.containsOption ("--uid"))   config.uid = (uint32_t) args.getValueForOption ("--uid").getIntValue();
+        if (args.containsOption ("--watch"))
+        {
+            auto value = args.getValueForOption ("--watch");
+            config.watchMs = value.isEmpty() ? 1000 : juce::jmax (100, value.getIntValue());
+        }
+        config.json = args.containsOption ("--json");
+        config.clean = args.containsOption ("--clean");
+        return config;
+    }
+};
+
+/** One process's segment, mapped read-only for the lifetime of the object. */
+class MappedSegment
+{
+public:
+    explicit MappedSegment (const std::string& name)
+    {
+        int fd = shm_open (name.c_str(), O_RDONLY, 0);
+        if (fd < 0)
+            return;
+
+        struct stat info {};
+        if (fstat (fd, &info) == 0 && (size_t) info.st_size >= sizeof (StatsExport::Layout))
+        {
+            auto* mapping = mmap (nullptr, sizeof (StatsExport::Layout), PROT_READ, MAP_SHARED, fd, 0);
+            if (mapping != MAP_FAILED)
+                layout = static_cast<const StatsExport::Layout*> (mapping);
+        }
+        close (fd);
+    }
+
+    ~MappedSegment()
+    {
+        if (layout != nullptr)
+            munmap (const_cast<StatsExport::Layout*> (layout), sizeof (StatsExport::Layout));
+    }
+
+    /** Null unless the segment is complete and has the layout this reader was built against. */
+    const StatsExport::Layout* get() const
+    {
+        if (layout == nullptr
+            || layout->magic.load (std::memory_order_acquire) != StatsExport::segmentMagic
+            || layout->version != StatsExport::segmentVersion
+            || layout->recordSize != sizeof (StatsExport::Record)
+            || layout->numRecords != (uint32_t) StatsExport::maxInstances)
+            return nullptr;
+
+        return layout;
+    }
+
+private:
+    const StatsExport::Layout* layout = nullptr;
+
+    JUCE_DECLARE_NON_COPYABLE (MappedSegment)
+};
+
+static bool isProcessAlive (int pid)
+{
+    return kill (pid, 0) == 0 || errno == EPERM;
+}
+
+static juce::var toVar (int pid, const juce::String& host, const StatsExport::Stats& stats)
+{
+    auto* object = new juce::DynamicObject();
+    object->setProperty ("pid", pid);
+    object->setProperty ("host", host);
+    object->setProperty ("instance", (juce::int64) stats.instanceId);
+    object->setProperty ("updatedMs", (juce::int64) stats.updatedMs);
+    object->setProperty ("currentWindow", (juce::int64) stats.currentWindow);
+    object->setProperty ("currentWindowMs", stats.currentWindowMs);
+    object->setProperty ("pendingWindows", stats.pendingWindows);
+    object->setProperty ("pendingMs", (juce::int64) stats.pendingMs);
+    object->setProperty ("signalHot", (stats.flags & StatsExport::signalHot) != 0);
+    object->setProperty ("connectionHealthy", (stats.flags & StatsExport::connectionHealthy) != 0);
+    object->setProperty ("sessionKeyValidated", (stats.flags & StatsExport::sessionKeyValidated) != 0);
+    object->setProperty ("deepIdle", (stats.flags & StatsExport::deepIdle) != 0);
+    object->setProperty ("leader", (stats.flags & StatsExport::leader) != 0);
+    return object;
+}
+
+static juce::String describe (int pid, const juce::String& host, const StatsExport::Stats& stats)
+{
+    auto flag = [&stats] (uint32_t bit, const char* set, const char* clear) { return (stats.flags & bit) != 0 ? set : clear; };
+    auto ageSeconds = (double) (juce::Time::currentTimeMillis() - stats.updatedMs) / 1000.0;
+
+    return juce::String (pid).paddedRight (' ', 8)
+         + host.substring (0, 18).paddedRight (' ', 20)
+         + ("#" + juce::String ((uint32_t) stats.instanceId)).paddedRight (' ', 6)
+         + juce::String (flag (StatsExport::deepIdle, "idle", flag (StatsExport::signalHot, "hot", "quiet"))).paddedRight (' ', 7)
+         + (juce::String (stats.currentWindowMs) + " ms").paddedRight (' ', 10)
+         + (juce::String (stats.pendingWindows) + " / " + juce::String (stats.pendingMs) + " ms").paddedRight (' ', 18)
+         + juce::String (flag (StatsExport::connectionHealthy, "healthy", "offline")).paddedRight (' ', 9)
+         + juce::String (flag (StatsExport::sessionKeyValidated, "valid", "no")).paddedRight (' ', 7)
+         + juce::String (flag (StatsExport::leader, "yes", "")).paddedRight (' ', 8)
+         + juce::String (ageSeconds, 1) + " s ago";
+}
+
+/** Reads every segment for the user once; returns the number of live instances. */
+static int poll (const StatsReaderConfig& config)
+{
+    const auto prefix = StatsExport::getSegmentPrefix (config.uid);
+    const auto fileFrom = juce::String (prefix).substring (1);
+
+    juce::Array<juce::File> files;
+    juce::File ("/dev/shm").findChildFiles (files, juce::File::findFiles, false, fileFrom + "*");
+    files.sort();
+
+    juce::Array<juce::var> instances;
+    juce::StringArray lines;
+
+    for (auto& file : files)
+    {
+        auto pid = file.getFileName().fromFirstOccurrenceOf (fileFrom, false, false).getIntValue();
+        auto name = prefix + std::to_string (pid);
+
+        if (pid <= 0 || ! isProcessAlive (pid))
+        {
+            if (config.clean)
+                shm_unlink (name.c_str());
+            if (! config.json)
+                std::cerr << file.getFileName() << ": stale, process " << pid << " has exited"
+                          << (config.clean ? ", removed" : " (remove with --clean)") << std::endl;
+            continue;
+        }
+
+        MappedSegment segment (name);
+        auto* layout = segment.get();
+        if (layout == nullptr)
+        {
+            if (! config.json)
+                std::cerr << file.getFileName() << ": not ready or an unknown layout" << std::endl;
+            continue;
+        }
+
+        auto host = juce::String::fromUTF8 (layout->host, (int) strnlen (layout->host, StatsExport::hostBytes));
+        for (const auto& record : layout->records)
+        {
+            StatsExport::Stats stats;
+            if (! StatsExport::read (record, stats))
+                continue;
+
+            instances.add (toVar (pid, host, stats));
+            lines.add (describe (pid, host, stats));
+        }
+    }
+
+    if (config.json)
+    {
+        std::cout << juce::JSON::toString (juce::var (instances), true) << std::endl;
+    }
+    else
+    {
+        std::cout << "PID     HOST                INST  SIGNAL WINDOW    PENDING           NETWORK  KEY    LEADER  UPDATED" << std::endl;
+        for (auto& line : lines)
+            std::cout << line << std::endl;
+        if (lines.isEmpty())
+            std::cout << "(no running instances)" << std::endl;
+    }
+
+    return instances.size();
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ArgumentList args (argc, argv);
+
+    if (args.containsOption ("--help|-h"))
+    {
+        std::cout << "Usage: " << args.executableName << " [options]\n"
+                  << "  --watch[=MS]   poll every MS milliseconds (default 1000) until interrupted\n"
+                  << "  --json         print one JSON array of instances per poll\n"
+                  << "  --uid=N        read another user's segments (needs read permission)\n"
+                  << "  --clean        remove segments left by processes that have exited\n";
+        return 0;
+    }
+
+    auto config = StatsReaderConfig::fromArguments (args);
+
+    if (config.watchMs == 0)
+        return poll (config) > 0 ? 0 : 1;
+
+    for (;;)
+    {
+        poll (config);
+        std::cout << std::endl;
+        juce::Thread::sleep (config.watchMs);
+    }
+}
@@ -0,0 +1,409 @@
+/*
+  ==============================================================================
+
+    Stress.cpp
+
+    Drives real processors from every thread that touches them in a host, all
+    at once, against the in-process mock API on an accelerated clock:
+
+    - audio threads call processBlock (tools/harness AudioDriver);
+    - the message thread runs the processors' timers and calls timerCallback
+      again between them, as a busy editor and host would;
+    - hammer threads call commitActivity and flushAccumulator at random, as
+      connection callbacks and releaseResources do on host threads.
+
+    Meanwhile the mock injects 429s, 5xx and disconnects. With --outage-minutes
+    the API also goes away entirely for that long, a quarter of the way in,
+    with the backlog budget at its minimum, so the backlog has to merge windows
+    into buckets; the run fails if no bucket reaches the server. At the end the
+    faults are switched off and the backlogs drain. The tool then reports the processor
+    lock's acquisitions, contention and hold times (built with
+    SIGNALBASH_LOCK_STATS=1), and compares what the server accepted with a
+    ground truth kept by the audio threads: every active block, laid on the
+    same per-instance timeline as ActivityAccountant and merged at the shared
+    segment's slot resolution. Lost and duplicated milliseconds are reported
+    per span the server saw, and the tool exits with 1 if either exceeds
+    --tolerance-ms.
+
+    Build with -DSIGNALBASH_TSAN=ON (see run_tsan.sh) to run it under
+    ThreadSanitizer.
+
+  ==============================================================================
+*/
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <JuceHeader.h>
+
+#include "ActivityAccountant.h"
+#include "ActivityBacklog.h"
+#include "../harness/ProcessorHarness.h"
+#include "../mock_server/MockApiServer.h"
+
+struct StressConfig
+{
+    int instances = 8;
+    int audioThreads = 3;
+    int hammerThreads = 2;
+    double minutes = 60.0;
+    double speed = 30.0;
+    double sampleRate = 48000.0;
+    int blockSize = 256;
+    int hammerIntervalMs = 5;
+    int settleSeconds = 30;
+    int toleranceMs = 0;
+    double outageMinutes = 0.0;
+    MockServerConfig server;
+
+    static StressConfig fromArguments (const juce::ArgumentList& args)
+    {
+        StressConfig config;
+        auto intArg    = [&args] (const char* name, int fallback)    { return args.containsOption (name) ? args.getValueForOption (name).getIntValue() : fallback; };
+        auto doubleArg = [&args] (const char* name, double fallback) { return args.containsOption (name) ? args.getValueForOption (name).getDoubleValue() : fallback; };
+
+        config.instances        = juce::jmax (1, intArg ("--instances", config.instances));
+        config.audioThreads     = juce::jmax (1, intArg ("--audio-threads", config.audioThreads));
+        config.hammerThreads    = juce::jmax (0, intArg ("--hammer-threads", config.hammerThreads));
+        config.minutes          = juce::jmax (1.0, doubleArg ("--minutes", config.minutes));
+        config.speed            = juce::jlimit (1.0, 600.0, doubleArg ("--speed", config.speed));
+        config.sampleRate       = doubleArg ("--sample-rate", config.sampleRate);
+        config.blockSize        = juce::jmax (16, intArg ("--block-size", config.blockSize));
+        config.hammerIntervalMs = juce::jmax (0, intArg ("--hammer-interval-ms", config.hammerIntervalMs));
+        config.settleSeconds    = juce::jmax (1, intArg ("--settle-seconds", config.settleSeconds));
+        config.toleranceMs      = juce::jmax (0, intArg ("--tolerance-ms", config.toleranceMs));
+        config.outageMinutes    = juce::jlimit (0.0, config.minutes * 0.75, doubleArg ("--outage-minutes", config.outageMinutes));
+
+        // faults on by default, and a port of its own
+        config.server = MockServerConfig::fromArguments (args);
+        if (! args.containsOption ("--port"))            config.server.port = 7578;
+        if (! args.containsOption ("--rate-429"))        config.server.rate429 = 0.05;
+        if (! args.containsOption ("--rate-5xx"))        config.server.rate5xx = 0.02;
+        if (! args.containsOption ("--rate-disconnect")) config.server.rateDisconnect = 0.02;
+        if (! args.containsOption ("--retry-after"))     config.server.retryAfterSeconds = 1;
+        return config;
+    }
+};
+
+//==============================================================================
+/** Each instance plays in bursts of its own length, so the instances overlap in every combination. */
+static bool isPlaying (int instance, int64_t nowMs)
+{
+    const auto periodMs = (int64_t) (37 + 11 * instance) * 1000;
+    const auto phase = (periodMs * instance) / 7;
+    return (nowMs + phase) % periodMs < periodMs * 3 / 5;
+}
+
+//==============================================================================
+/** The time the run actually played, at the shared segment's slot resolution.
+    Each instance's blocks are laid end to end from the wall clock, as
+    ActivityAccountant offers them to the segment, and merged across instances,
+    as the segment does for instances on one host and key.
+*/
+class GroundTruth
+{
+public:
+    GroundTruth (int64_t startMsToUse, int64_t lengthMs, int numInstances)
+        : startMs (startMsToUse - startMsToUse % windowMs),
+          bits ((size_t) ((lengthMs + 2 * windowMs) / slotMs / 64 + 1)),
+          timelines ((size_t) numInstances, 0.0)
+    {
+    }
+
+    /** Called by the audio thread that owns the instance. */
+    void add (int instance, int64_t nowMs, double blockMs)
+    {
+        auto& timeline = timelines[(size_t) instance];
+        const auto from = juce::jmax ((double) nowMs, timeline);
+        if (from - (double) nowMs > ActivityAccountant::maxLeadMs)
+            return;
+
+        timeline = from + blockMs;
+
+        const auto first = (std::llround (from) - startMs) / slotMs;
+        const auto end = (std::llround (from + blockMs) - startMs + slotMs - 1) / slotMs;
+        for (auto slot = juce::jmax ((int64_t) 0, first); slot < end && (size_t) (slot / 64) < bits.size(); ++slot)
+            bits[(size_t) (slot / 64)].fetch_or (uint64_t { 1 } << (slot % 64), std::memory_order_relaxed);
+    }
+
+    /** Played milliseconds in [fromSeconds, fromSeconds + seconds). */
+    int64_t millisecondsIn (int64_t fromSeconds, int64_t seconds) const
+    {
+        int64_t total = 0;
+        const auto first = juce::jmax ((int64_t) 0, (fromSeconds * 1000 - startMs) / slotMs);
+        const auto end = juce::jmin ((int64_t) bits.size() * 64, ((fromSeconds + seconds) * 1000 - startMs) / slotMs);
+        for (auto slot = first; slot < end; ++slot)
+            if ((bits[(size_t) (slot / 64)].load (std::memory_order_relaxed) >> (slot % 64)) & 1)
+                total += slotMs;
+        return total;
+    }
+
+    int64_t getStartSeconds() const { return startMs / 1000; }
+
+private:
+    static constexpr int64_t slotMs = SharedActivitySegment::slotMs;
+    static constexpr int64_t windowMs = SharedActivitySegment::windowSeconds * 1000;
+
+    const int64_t startMs;
+    std::vector<std::atomic<uint64_t>> bits;
+    std::vector<double> timelines;      // per instance, owned by its audio thread
+};
+
+//==============================================================================
+struct Reconciliation
+{
+    int64_t playedMs = 0, acceptedMs = 0, lostMs = 0, duplicatedMs = 0;
+    std::vector<juce::String> mismatches;
+};
+
+/** Groups what the server accepted into runs of overlapping spans (a bucket
+    and the windows or parts inside it land in one run) and compares each run,
+    and everything no run covers, with the ground truth.
+*/
+static Reconciliation reconcile (const GroundTruth& truth, std::vector<MockServerStats::AcceptedSpan> spans, int64_t endSeconds)
+{
+    Reconciliation result;
+    std::sort (spans.begin(), spans.end(), [] (const auto& a, const auto& b) { return a.start < b.start; });
+
+    auto compare = [&result, &truth] (int64_t from, int64_t to, int64_t accepted)
+    {
+        const auto played = truth.millisecondsIn (from, to - from);
+        result.playedMs += played;
+        result.acceptedMs += accepted;
+        if (played == accepted)
+            return;
+
+        result.lostMs += juce::jmax ((int64_t) 0, played - accepted);
+        result.duplicatedMs += juce::jmax ((int64_t) 0, accepted - played);
+        result.mismatches.push_back (juce::String (from) + "+" + juce::String (to - from) + "s: played "
+                                     + juce::String (played) + " ms, accepted " + juce::String (accepted) + " ms");
+    };
+
+    auto covered = truth.getStartSeconds();
+    for (size_t i = 0; i < spans.size();)
+    {
+        auto runStart = spans[i].start, runEnd = spans[i].start + spans[i].seconds;
+        int64_t accepted = 0;
+        for (; i < spans.size() && spans[i].start < runEnd; ++i)
+        {
+            runEnd = juce::jmax (runEnd, spans[i].start + spans[i].seconds);
+            accepted += spans[i].milliseconds;
+        }
+
+        if (runStart > covered)
+            compare (covered, runStart, 0);
+        compare (runStart, runEnd, accepted);
+        covered = juce::jmax (covered, runEnd);
+    }
+
+    if (endSeconds > covered)
+        compare (covered, endSeconds, 0);
+    return result;
+}
+
+//==============================================================================
+/** Calls commitActivity and flushAccumulator on random instances until stopped. */
+class Hammer
+{
+public:
+    Hammer (std::vector<SignalbashAudioProcessor*> processorsToUse, int numThreads, int intervalMs)
+        : processors (std::move (processorsToUse))
+    {
+        for (int t = 0; t < numThreads; ++t)
+            threads.emplace_back ([this, t, intervalMs] { run ((unsigned) t, intervalMs); });
+    }
+
+    ~Hammer() { stop(); }
+
+    void stop()
+    {
+        running.store (false);
+        for (auto& thread : threads)
+            if (thread.joinable())
+                thread.join();
+    }
+
+    int64_t getCalls() const { return calls.load(); }
+
+private:
+    std::vector<SignalbashAudioProcessor*> processors;
+    std::atomic<bool> running { true };
+    std::atomic<int64_t> calls { 0 };
+    std::vector<std::thread> threads;
+
+    void run (unsigned seed, int intervalMs)
+    {
+        std::mt19937 random (seed);
+        while (running.load (std::memory_order_relaxed))
+        {
+            auto* processor = processors[random() % processors.size()];
+            if (random() % 4 == 0)
+                processor->flushAccumulator();
+            else
+                processor->commitActivity();
+
+            ++calls;
+            std::this_thread::sleep_for (std::chrono::milliseconds (intervalMs));
+        }
+    }
+};
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ArgumentList args (argc, argv);
+
+    if (args.containsOption ("--help|-h"))
+    {
+        std::cout << "Usage: " << args.executableName << " [options]\n"
+                  << "  --instances=N            processors to run (default 8)\n"
+                  << "  --audio-threads=N        threads calling processBlock (default 3)\n"
+                  << "  --hammer-threads=N       threads calling commitActivity / flushAccumulator (default 2)\n"
+                  << "  --hammer-interval-ms=N   real time between a hammer thread's calls (default 5)\n"
+                  << "  --minutes=M              simulated minutes of playing (default 60)\n"
+                  << "  --speed=X                simulated seconds per real second (default 30)\n"
+                  << "  --sample-rate=R          (default 48000)\n"
+                  << "  --block-size=N           (default 256)\n"
+                  << "  --settle-seconds=N       real time for the backlogs to drain, faults off (default 30)\n"
+                  << "  --tolerance-ms=N         lost or duplicated milliseconds allowed (default 0)\n"
+                  << "  --outage-minutes=M       simulated minutes with the API down, a quarter of the way in,\n"
+                  << "                           with the smallest backlog budget so it has to merge (default 0)\n"
+                  << "  --port=N, --latency-ms=N, --latency-jitter-ms=N, --rate-429=P, --rate-5xx=P,\n"
+                  << "  --rate-disconnect=P, --retry-after=N\n"
+                  << "                           as for signalbash-mock-server (port 7578, rates 0.05 / 0.02 / 0.02,\n"
+                  << "                           retry-after 1 by default)\n";
+        return 0;
+    }
+
+    auto config = StressConfig::fromArguments (args);
+    ProcessorHarness::ScratchEnvironment environment ("signalbash-stress", config.speed);
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    if (! InstrumentedCriticalSection::statsEnabled)
+        std::cout << "Built without SIGNALBASH_LOCK_STATS; lock figures will read 0" << std::endl;
+
+    MockApiServer server (config.server);
+    if (! server.start())
+    {
+        std::cerr << "Could not listen on 127.0.0.1:" << config.server.port << std::endl;
+        return 1;
+    }
+
+    juce::StringPairArray settings;
+    settings.set ("apiBase", "http://127.0.0.1:" + juce::String (config.server.port));
+    settings.set ("sessionKey", "stress-session-key");
+    if (config.outageMinutes > 0.0)
+        settings.set ("backlogMaxEntries", juce::String (ActivityBacklog::Budget::minEntries));
+    environment.writeSettings (settings);
+
+    juce::SharedResourcePointer<ClockService> clock;
+    const auto startMs = clock->nowMs();
+    const auto playMs = (int64_t) (config.minutes * 60.0 * 1000.0);
+    GroundTruth truth (startMs, playMs, config.instances);
+
+    const auto outageFromMs = startMs + playMs / 4;
+    const auto outageToMs = outageFromMs + (int64_t) (config.outageMinutes * 60.0 * 1000.0);
+
+    std::vector<std::unique_ptr<SignalbashAudioProcessor>> processors;
+    std::vector<SignalbashAudioProcessor*> driven;
+    for (int i = 0; i < config.instances; ++i)
+    {
+        processors.push_back (ProcessorHarness::createProcessor (config.sampleRate, config.blockSize));
+        driven.push_back (processors.back().get());
+    }
+
+    std::cout << "Stressing " << config.instances << " instances on " << config.audioThreads << " audio and "
+              << config.hammerThreads << " hammer threads for " << config.minutes << " simulated minutes at "
+              << config.speed << "x" << std::endl;
+
+    int64_t extraTimerCalls = 0, lateBlocks = 0, blocks = 0, hammerCalls = 0;
+    {
+        ProcessorHarness::AudioDriver driver (driven, config.audioThreads, config.sampleRate, config.blockSize,
+                                              [] (int instance, int64_t nowMs) { return isPlaying (instance, nowMs); },
+                                              [&truth, &driven] (int instance, int64_t, double blockMs, bool active)
+                                              {
+                                                  // the time processBlock itself read, which is what the accountant laid the block at
+                                                  if (active)
+                                                      truth.add (instance, driven[(size_t) instance]->audioState.lastActiveBlockTimestamp.load (std::memory_order_relaxed), blockMs);
+                                              });
+        Hammer hammer (driven, config.hammerThreads, config.hammerIntervalMs);
+
+        while (clock->nowMs() < startMs + playMs)
+        {
+            const auto now = clock->nowMs();
+            server.setOutage (now >= outageFromMs && now < outageToMs);
+
+            ProcessorHarness::runMessageLoop (10);
+            for (auto* processor : driven)
+                processor->timerCallback();
+            ++extraTimerCalls;
+        }
+
+        driver.stop();
+        hammer.stop();
+        lateBlocks = driver.getLateBlocks();
+        blocks = driver.getBlocksProcessed();
+        hammerCalls = hammer.getCalls();
+    }
+    const auto endSeconds = (clock->nowMs() + 999) / 1000;
+
+    // faults off, the host stopping: every backlog should now reach the server
+    server.setOutage (false);
+    server.setFaultInjection (false);
+    for (auto* processor : driven)
+        processor->releaseResources();
+    ProcessorHarness::runMessageLoop (config.settleSeconds * 1000);
+
+    InstrumentedCriticalSection::Stats lock;
+    for (auto* processor : driven)
+    {
+        auto stats = processor->mutex.getStats();
+        lock.acquisitions += stats.acquisitions;
+        lock.contended += stats.contended;
+        lock.totalHoldMicroseconds += stats.totalHoldMicroseconds;
+        lock.maxHoldMicroseconds = juce::jmax (lock.maxHoldMicroseconds, stats.maxHoldMicroseconds);
+    }
+    processors.clear();
+
+    auto result = reconcile (truth, server.getAcceptedSpans(), endSeconds);
+    for (size_t i = 0; i < result.mismatches.size() && i < 20; ++i)
+        std::cout << "  " << result.mismatches[i] << std::endl;
+    if (result.mismatches.size() > 20)
+        std::cout << "  ... " << result.mismatches.size() - 20 << " more" << std::endl;
+
+    if (lateBlocks > 0)
+        std::cout << "Audio threads fell behind on " << lateBlocks << " of " << blocks
+                  << " blocks; lower --speed or --instances for faithful timing" << std::endl;
+
+    auto* summary = new juce::DynamicObject();
+    summary->setProperty ("instances", config.instances);
+    summary->setProperty ("simulated_minutes", config.minutes);
+    summary->setProperty ("blocks", (juce::int64) blocks);
+    summary->setProperty ("extra_timer_calls", (juce::int64) extraTimerCalls * config.instances);
+    summary->setProperty ("hammer_calls", (juce::int64) hammerCalls);
+    summary->setProperty ("lock_acquisitions", (juce::int64) lock.acquisitions);
+    summary->setProperty ("lock_contended", (juce::int64) lock.contended);
+    summary->setProperty ("lock_contention_ratio", lock.acquisitions > 0 ? (double) lock.contended / (double) lock.acquisitions : 0.0);
+    summary->setProperty ("lock_mean_hold_us", lock.acquisitions > 0 ? lock.totalHoldMicroseconds / (double) lock.acquisitions : 0.0);
+    summary->setProperty ("lock_max_hold_us", lock.maxHoldMicroseconds);
+    summary->setProperty ("played_ms", (juce::int64) result.playedMs);
+    summary->setProperty ("accepted_ms", (juce::int64) result.acceptedMs);
+    summary->setProperty ("lost_ms", (juce::int64) result.lostMs);
+    summary->setProperty ("duplicated_ms", (juce::int64) result.duplicatedMs);
+    summary->setProperty ("server", server.getStats());
+    std::cout << juce::JSON::toString (juce::var (summary), true) << std::endl;
+
+    auto ok = result.lostMs <= config.toleranceMs && result.duplicatedMs <= config.toleranceMs;
+
+    const auto acceptedBuckets = (int64_t) server.getStats().getProperty ("accepted_buckets", 0);
+    if (config.outageMinutes > 0.0 && acceptedBuckets == 0)
+    {
+        std::cout << "The outage never made a backlog merge windows; lengthen --outage-minutes" << std::endl;
+        ok = false;
+    }
+
+    std::cout << (ok ? "PASS" : "FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,20 @@
+#!/bin/bash
+# ThreadSanitizer run of the stress tool, for CI or by hand (Linux, clang or gcc).
+# Fails on the first data race TSan reports, or if the run loses or duplicates time.
+# Extra arguments go to signalbash-stress, e.g. ./tools/stress/run_tsan.sh --minutes=120
+set -e
+
+cd "$(dirname "$0")/../.."
+
+cmake -B build-tsan \
+    -DCMAKE_BUILD_TYPE=RelWithDebInfo \
+    -DSIGNALBASH_TSAN=ON \
+    -DSIGNALBASH_LOCK_STATS=ON
+
+cmake --build build-tsan --target SignalbashStress -j"$(nproc)"
+
+STRESS=$(find build-tsan -type f -name signalbash-stress -perm -u+x | head -n 1)
+
+# TSan slows everything down; keep the simulated clock slow enough for the audio threads to keep up
+TSAN_OPTIONS="halt_on_error=1 second_deadlock_stack=1 ${TSAN_OPTIONS}" \
+    "$STRESS" --minutes=30 --speed=10 --settle-seconds=60 "$@"